@@ -16,6 +16,9 @@ public class AntiquatedFuture : ModuleRules
 			"InputCore", 
 			"EnhancedInput",
 			"Niagara",
+			"NetCore",
+			"Icmp",
+			"Networking",
 			"OnlineSubsystem",
 			"OnlineSubsystemEOS",
 			"OnlineSubsystemUtils",
@@ -4,4 +4,13 @@
 #include "Modules/ModuleManager.h"
 
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, AntiquatedFuture, "AntiquatedFuture" );
- 
\ No newline at end of file
+
+LLM_DEFINE_TAG(Submarine);
+LLM_DEFINE_TAG(Submarine_Pawn, NAME_None, TEXT("Submarine"));
+LLM_DEFINE_TAG(Submarine_Weapon, NAME_None, TEXT("Submarine"));
+LLM_DEFINE_TAG(Submarine_Projectile, NAME_None, TEXT("Submarine"));
+LLM_DEFINE_TAG(Submarine_Online, NAME_None, TEXT("Submarine"));
+
+DEFINE_LOG_CATEGORY(LogSubmarine);
+DEFINE_LOG_CATEGORY(LogSubmarineNet);
+DEFINE_LOG_CATEGORY(LogSubmarineOnline);
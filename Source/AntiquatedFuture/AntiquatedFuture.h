@@ -3,3 +3,56 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+
+// Low level memory tags, so our allocations don't disappear into the engine's buckets. Run with -llm to see them in
+// `stat LLMFULL` and memreport, or -llmcsv to write them to Saved/Profiling/LLM every few seconds.
+LLM_DECLARE_TAG(Submarine);
+LLM_DECLARE_TAG(Submarine_Pawn);
+LLM_DECLARE_TAG(Submarine_Weapon);
+// Projectiles, their tracers, hit events and hit effects
+LLM_DECLARE_TAG(Submarine_Projectile);
+// Session searches, the lobby browser and travel preloads
+LLM_DECLARE_TAG(Submarine_Online);
+
+// Net and online logging compiles down to warnings and errors in Shipping, so those call sites cost nothing there
+#if UE_BUILD_SHIPPING
+#define SUBMARINE_NET_LOG_COMPILE_VERBOSITY Warning
+#else
+#define SUBMARINE_NET_LOG_COMPILE_VERBOSITY All
+#endif
+
+// Gameplay: pawns, weapons, projectiles
+ANTIQUATEDFUTURE_API DECLARE_LOG_CATEGORY_EXTERN(LogSubmarine, Log, All);
+// Movement and weapon replication, RPC budgets, net stats
+ANTIQUATEDFUTURE_API DECLARE_LOG_CATEGORY_EXTERN(LogSubmarineNet, Log, SUBMARINE_NET_LOG_COMPILE_VERBOSITY);
+// Log in, sessions, lobby browser, joining
+ANTIQUATEDFUTURE_API DECLARE_LOG_CATEGORY_EXTERN(LogSubmarineOnline, Log, SUBMARINE_NET_LOG_COMPILE_VERBOSITY);
+
+/**
+ * UE_LOG that fires at most once every Interval seconds from each call site, and says how many it skipped in between.
+ * For anything that can go off every frame or every packet when the network gets bad. Nothing is formatted, and the
+ * arguments aren't even evaluated, unless the line actually gets written.
+ */
+#define SUBMARINE_LOG_RATE_LIMITED(Interval, CategoryName, Verbosity, Format, ...) \
+	do \
+	{ \
+		if (UE_LOG_ACTIVE(CategoryName, Verbosity)) \
+		{ \
+			static double SubmarineLogNextTime = 0.0; \
+			static int32 SubmarineLogNumSuppressed = 0; \
+			const double SubmarineLogNow = FPlatformTime::Seconds(); \
+			if (SubmarineLogNow < SubmarineLogNextTime) \
+			{ \
+				++SubmarineLogNumSuppressed; \
+			} \
+			else \
+			{ \
+				SubmarineLogNextTime = SubmarineLogNow + (Interval); \
+				UE_LOG(CategoryName, Verbosity, Format TEXT(" (%d more suppressed)"), ##__VA_ARGS__, \
+					SubmarineLogNumSuppressed); \
+				SubmarineLogNumSuppressed = 0; \
+			} \
+		} \
+	} \
+	while (false)
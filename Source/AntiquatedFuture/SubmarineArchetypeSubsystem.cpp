@@ -0,0 +1,131 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SubmarineArchetypeSubsystem.h"
+#include "AntiquatedFuture.h"
+#include "NiagaraSystem.h"
+#include "SubmarineProjectile.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "UObject/UObjectHash.h"
+
+void USubmarineArchetypeSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	PreloadArchetypes();
+}
+
+void USubmarineArchetypeSubsystem::PreloadArchetypes()
+{
+	if (PreloadHandles.Num() > 0)
+	{
+		return;
+	}
+	TArray<FSoftObjectPath> Paths;
+	for (const auto& PreloadClass: PreloadClasses)
+	{
+		if (!PreloadClass.IsNull())
+		{
+			Paths.Add(PreloadClass.ToSoftObjectPath());
+		}
+	}
+	PreloadAsync(Paths);
+}
+
+void USubmarineArchetypeSubsystem::Deinitialize()
+{
+	for (const auto& Handle: PreloadHandles)
+	{
+		if (Handle.IsValid())
+		{
+			Handle->ReleaseHandle();
+		}
+	}
+	PreloadHandles.Empty();
+	for (auto& Pair: ProjectileArchetypes)
+	{
+		if (Pair.Value.AssetHandle.IsValid())
+		{
+			Pair.Value.AssetHandle->ReleaseHandle();
+		}
+	}
+	ProjectileArchetypes.Empty();
+	Super::Deinitialize();
+}
+
+void USubmarineArchetypeSubsystem::PreloadAsync(const TArray<FSoftObjectPath>& Paths)
+{
+	if (Paths.Num() == 0 || !UAssetManager::IsInitialized())
+	{
+		return;
+	}
+	const auto Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(Paths,
+		FStreamableDelegate::CreateUObject(this, &USubmarineArchetypeSubsystem::OnPreloadComplete));
+	if (Handle.IsValid())
+	{
+		PreloadHandles.Add(Handle);
+	}
+}
+
+void USubmarineArchetypeSubsystem::OnPreloadComplete()
+{
+	// Loading a submarine pulls in its weapons' projectile classes, so cache all of them before anyone fires
+	TArray<UClass*> ProjectileClasses;
+	GetDerivedClasses(ASubmarineProjectile::StaticClass(), ProjectileClasses);
+	for (UClass* ProjectileClass: ProjectileClasses)
+	{
+		if (!ProjectileClass->HasAnyClassFlags(CLASS_Abstract | CLASS_NewerVersionExists))
+		{
+			GetProjectileArchetype(ProjectileClass);
+		}
+	}
+}
+
+const FSubmarineProjectileArchetype& USubmarineArchetypeSubsystem::GetProjectileArchetype(
+	TSubclassOf<ASubmarineProjectile> ProjectileClass)
+{
+	if (ProjectileClass == nullptr)
+	{
+		// Not worth a map entry - callers see InitialSpeed < 0 and know nothing was cached
+		static const FSubmarineProjectileArchetype InvalidArchetype;
+		UE_LOG(LogSubmarine, Warning, TEXT("No projectile class to cache. This could cause problems!"));
+		return InvalidArchetype;
+	}
+	if (const FSubmarineProjectileArchetype* Existing = ProjectileArchetypes.Find(ProjectileClass))
+	{
+		return *Existing;
+	}
+
+	FSubmarineProjectileArchetype& Archetype = ProjectileArchetypes.Add(ProjectileClass);
+
+	const auto ProjectileDefaultObject = ProjectileClass->GetDefaultObject<ASubmarineProjectile>();
+	if (const auto MovementComponent = ProjectileDefaultObject->Movement)
+	{
+		UE_LOG(LogSubmarine, Log, TEXT("Caching projectile archetype %s: initial speed %f"),
+			*ProjectileClass->GetName(), MovementComponent->InitialSpeed);
+		Archetype.InitialSpeed = MovementComponent->InitialSpeed;
+		Archetype.MaxSpeed = MovementComponent->MaxSpeed;
+		Archetype.GravityScale = MovementComponent->ProjectileGravityScale;
+	}
+
+	// Everything the projectile draws when it's fired or when it hits
+	TArray<FSoftObjectPath> AssetPaths;
+	if (const auto Mesh = ProjectileDefaultObject->GetMesh())
+	{
+		AssetPaths.Add(Mesh->GetStaticMesh());
+		for (int i = 0; i < Mesh->GetNumMaterials(); ++i)
+		{
+			AssetPaths.Add(Mesh->GetMaterial(i));
+		}
+	}
+	AssetPaths.Add(ProjectileDefaultObject->GetInFlightParticleSystem());
+	AssetPaths.Add(ProjectileDefaultObject->GetHitParticleSystem());
+	AssetPaths.RemoveAll([](const FSoftObjectPath& Path) { return Path.IsNull(); });
+	if (AssetPaths.Num() > 0 && UAssetManager::IsInitialized())
+	{
+		Archetype.AssetHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(AssetPaths);
+	}
+	return Archetype;
+}
@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "SubmarineArchetypeSubsystem.generated.h"
+
+class ASubmarineProjectile;
+struct FStreamableHandle;
+
+USTRUCT()
+struct FSubmarineProjectileArchetype
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	float InitialSpeed = -1.f;
+	UPROPERTY()
+	float MaxSpeed = 0.f;
+	UPROPERTY()
+	float GravityScale = 0.f;
+
+	// Keeps the mesh, materials and FX resident so the first shot and first hit don't pay for them
+	TSharedPtr<FStreamableHandle> AssetHandle;
+};
+
+/**
+ * Loads submarine, weapon and projectile archetypes through the streamable manager while levels load, and caches the
+ * per-class data (e.g. ballistic constants) that every weapon instance used to compute for itself in BeginPlay.
+ * Lives on the Game Instance so nothing has to be reloaded between matches.
+ */
+UCLASS(Config=Game)
+class ANTIQUATEDFUTURE_API USubmarineArchetypeSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+	// Classes to start streaming in as soon as the game starts - anything they reference comes along with them
+	UPROPERTY(Config)
+	TArray<TSoftClassPtr<AActor>> PreloadClasses;
+
+	UPROPERTY()
+	TMap<TSubclassOf<ASubmarineProjectile>, FSubmarineProjectileArchetype> ProjectileArchetypes;
+
+	TArray<TSharedPtr<FStreamableHandle>> PreloadHandles;
+
+	void OnPreloadComplete();
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	void PreloadAsync(const TArray<FSoftObjectPath>& Paths);
+	// Streams in PreloadClasses, unless that's already been done
+	void PreloadArchetypes();
+	// A null class gets a default archetype (InitialSpeed < 0) that isn't cached
+	const FSubmarineProjectileArchetype& GetProjectileArchetype(TSubclassOf<ASubmarineProjectile> ProjectileClass);
+};
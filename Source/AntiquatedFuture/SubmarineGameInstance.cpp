@@ -1,6 +1,7 @@
 ﻿// Fill out your copyright notice in the Description page of Project Settings.
 
 #include "SubmarineGameInstance.h"
+#include "AntiquatedFuture.h"
 
 #include "OnlineSubsystem.h"
 #include "Interfaces/OnlineIdentityInterface.h"
@@ -8,37 +9,434 @@
 #include "Online/OnlineSessionNames.h"
 #include "OnlineSessionSettings.h"
 #include "OnlinesubsystemSessionSettings.h"
+#include "SubmarineArchetypeSubsystem.h"
 #include "SubmarineSession.h"
+#include "SubmarineSessionBrowser.h"
+#include "SubmarineTestOnline.h"
+#include "OnlineSubsystemNames.h"
+#include "Algo/Reverse.h"
+#include "Engine/AssetManager.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/PlayerController.h"
+#include "Engine/StreamableManager.h"
 #include "Kismet/GameplayStatics.h"
+#include "Misc/NetworkVersion.h"
+#include "Misc/PackageName.h"
 
 USubmarineGameInstance::USubmarineGameInstance()
 {
 	bIsLan = false;
 	NumPlayers = 12;
 	bUsePresence = true;
+	GameMode = "Deathmatch";
+	MaxSearchResults = 100;
+	bUseTestOnlineSubsystem = false;
+	TestSimulatedLatency = 0.f;
+	TestSyntheticResults = 0;
+	bLogInOnStartup = true;
+	bTestPersistentLogInFails = false;
+	DedicatedServerName = "Submarine Dedicated Server";
+	MatchMapName = "/Game/GameJam/Maps/ArenaMap";
+	OccupancyUpdateInterval = 2.f;
+	OnlineOperationTimeout = 30.f;
+	PersistentLogInTimeout = 5.f;
+	QuickJoinAttemptTimeout = 8.f;
+	QuickJoinMaxAttempts = 6;
+	QuickJoinMaxSearches = 3;
+	QuickJoinRetryDelay = 1.f;
 }
 
 void USubmarineGameInstance::Init()
 {
 	Super::Init();
 
-	OnlineSubsystem = IOnlineSubsystem::Get();
-	
+	bUseTestOnlineSubsystem |= FParse::Param(FCommandLine::Get(), TEXT("SubmarineTestOnline"));
+	if (bUseTestOnlineSubsystem)
+	{
+		FParse::Value(FCommandLine::Get(), TEXT("SubmarineTestLatency="), TestSimulatedLatency);
+		FParse::Value(FCommandLine::Get(), TEXT("SubmarineTestResults="), TestSyntheticResults);
+		bTestPersistentLogInFails |= FParse::Param(FCommandLine::Get(), TEXT("SubmarineTestNoCachedLogIn"));
+		UE_LOG(LogSubmarineOnline, Warning,
+			TEXT("Using the Null online subsystem with %.2fs latency and %d synthetic sessions"),
+			TestSimulatedLatency, TestSyntheticResults)
+		OnlineSubsystem = IOnlineSubsystem::Get(NULL_SUBSYSTEM);
+	}
+	else
+	{
+		OnlineSubsystem = IOnlineSubsystem::Get();
+	}
+	SessionBrowser = NewObject<USubmarineSessionBrowser>(this);
+	SessionBrowser->SetRequiredBuildVersion(SettingKeyBuildVersion, GetBuildVersion());
+	SessionBrowser->SetNumPlayersKey(SettingKeyNumPlayers);
+
+	PreLoadMapHandle = FCoreUObjectDelegates::PreLoadMap.AddUObject(this, &USubmarineGameInstance::OnPreLoadMap);
+	PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(
+		this, &USubmarineGameInstance::OnPostLoadMap);
+	PostLoginHandle = FGameModeEvents::GameModePostLoginEvent.AddUObject(
+		this, &USubmarineGameInstance::OnGameModePostLogin);
+	LogoutHandle = FGameModeEvents::GameModeLogoutEvent.AddUObject(this, &USubmarineGameInstance::OnGameModeLogout);
+
+	// Overlaps the backend round trip with the rest of startup, so the menu usually finds us logged in already
+	if (bLogInOnStartup && !IsDedicatedServerInstance() && OnlineSubsystem && !IsLoggedIn())
+	{
+		LogIn();
+	}
+}
+
+void USubmarineGameInstance::Shutdown()
+{
+	FCoreUObjectDelegates::PreLoadMap.Remove(PreLoadMapHandle);
+	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapHandle);
+	FGameModeEvents::GameModePostLoginEvent.Remove(PostLoginHandle);
+	FGameModeEvents::GameModeLogoutEvent.Remove(LogoutHandle);
+	ReleaseTravelPreload();
+	Super::Shutdown();
+}
+
+void USubmarineGameInstance::PrewarmTravel(const FOnlineSessionSearchResult& SearchResult)
+{
+	LLM_SCOPE_BYTAG(Submarine_Online);
+	// Everything the match needs that doesn't depend on the server - normally already resident since startup
+	if (const auto ArchetypeSubsystem = GetSubsystem<USubmarineArchetypeSubsystem>())
+	{
+		ArchetypeSubsystem->PreloadArchetypes();
+	}
+
+	FString MapName;
+	if (!SearchResult.Session.SessionSettings.Get(SETTING_MAPNAME, MapName) || MapName.IsEmpty())
+	{
+		MapName = MatchMapName;
+	}
+	if (MapName.IsEmpty() || !UAssetManager::IsInitialized())
+	{
+		return;
+	}
+	// Map packages hold a single world asset with the same name
+	const FSoftObjectPath MapPath(FString::Printf(TEXT("%s.%s"), *MapName, *FPackageName::GetShortName(MapName)));
+	if (TravelPreloadHandle.IsValid() && TravelPreloadPath == MapPath)
+	{
+		return;
+	}
+	ReleaseTravelPreload();
+	UE_LOG(LogSubmarineOnline, Log, TEXT("Prewarming %s while we join"), *MapPath.ToString())
+	TravelPreloadPath = MapPath;
+	TravelPreloadHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(MapPath);
+}
+
+void USubmarineGameInstance::ReleaseTravelPreload()
+{
+	if (TravelPreloadHandle.IsValid())
+	{
+		TravelPreloadHandle->ReleaseHandle();
+		TravelPreloadHandle.Reset();
+	}
+}
+
+void USubmarineGameInstance::OnGameModePostLogin(AGameModeBase* GameModeBase, APlayerController* NewPlayer)
+{
+	// A dedicated server has nobody sitting in front of it, so whatever local player it ended up with (e.g. one
+	// launched from the editor) must not take a submarine and a slot. Broadcast before the pawn is spawned.
+	if (IsDedicatedServerInstance() && NewPlayer && NewPlayer->IsLocalController())
+	{
+		UE_LOG(LogSubmarineOnline, Log, TEXT("Dedicated server, not spawning a pawn for local %s"),
+			*NewPlayer->GetName())
+		NewPlayer->StartSpectatingOnly();
+		return;
+	}
+	ScheduleOccupancyUpdate();
+}
+
+void USubmarineGameInstance::OnGameModeLogout(AGameModeBase* GameModeBase, AController* Exiting)
+{
+	ScheduleOccupancyUpdate();
+}
+
+void USubmarineGameInstance::ScheduleOccupancyUpdate()
+{
+	// Whatever else joins or leaves before the timer fires goes out in the same update
+	if (HostedSessionName.IsNone() || GetTimerManager().IsTimerActive(OccupancyUpdateTimer))
+	{
+		return;
+	}
+	GetTimerManager().SetTimer(OccupancyUpdateTimer, this, &USubmarineGameInstance::PushOccupancyUpdate,
+		OccupancyUpdateInterval, false);
+}
+
+void USubmarineGameInstance::PushOccupancyUpdate()
+{
+	const IOnlineSessionPtr Session = OnlineSubsystem ? OnlineSubsystem->GetSessionInterface() : nullptr;
+	const AGameModeBase* GameModeBase = GetWorld() ? GetWorld()->GetAuthGameMode() : nullptr;
+	if (!Session.IsValid() || GameModeBase == nullptr)
+	{
+		return;
+	}
+	FOnlineSessionSettings* CurrentSettings = Session->GetSessionSettings(HostedSessionName);
+	if (CurrentSettings == nullptr)
+	{
+		HostedSessionName = NAME_None;
+		return;
+	}
+
+	// Counts a listen server's own player too, same as the one it starts out advertising
+	const int32 NumConnectedPlayers = GameModeBase->GetNumPlayers();
+	int32 AdvertisedPlayers = 0;
+	if (CurrentSettings->Get(SettingKeyNumPlayers, AdvertisedPlayers) && AdvertisedPlayers == NumConnectedPlayers)
+	{
+		return;
+	}
+	FOnlineSessionSettings Settings = *CurrentSettings;
+	Settings.Set(SettingKeyNumPlayers, NumConnectedPlayers, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+	UE_LOG(LogSubmarineOnline, Log, TEXT("Advertising %d/%d players for %s"),
+		NumConnectedPlayers, Settings.NumPublicConnections, *HostedSessionName.ToString())
+	Session->UpdateSession(HostedSessionName, Settings, true);
+}
+
+void USubmarineGameInstance::OnPreLoadMap(const FString& MapName)
+{
+	JoinTimeline.Mark(ESubmarineJoinPhase::Connected);
+}
+
+void USubmarineGameInstance::OnPostLoadMap(UWorld* LoadedWorld)
+{
+	JoinTimeline.Mark(ESubmarineJoinPhase::MapLoaded);
+	// The world owns the map now
+	ReleaseTravelPreload();
+}
+
+void USubmarineGameInstance::OnStart()
+{
+	Super::OnStart();
+
+	// Nobody is going to click "Host" on a dedicated server, so advertise as soon as the game is up
+	if (IsDedicatedServerInstance())
+	{
+		CreateDedicatedSession();
+	}
+}
+
+int32 USubmarineGameInstance::GetBuildVersion()
+{
+	// Same checksum the net driver uses to refuse mismatched clients, so we never list a session we can't join
+	return static_cast<int32>(FNetworkVersion::GetLocalNetworkVersion());
+}
+
+void USubmarineGameInstance::LogOperationTime(const TCHAR* Operation, const double StartTime)
+{
+	UE_LOG(LogSubmarineOnline, Log, TEXT("%s took %.1f ms"), Operation, (FPlatformTime::Seconds() - StartTime) * 1000.0)
+}
+
+void USubmarineGameInstance::RunAfterSimulatedLatency(TFunction<void()>&& Operation)
+{
+	if (!bUseTestOnlineSubsystem || TestSimulatedLatency <= 0.f)
+	{
+		Operation();
+		return;
+	}
+	FTimerHandle Handle;
+	GetTimerManager().SetTimer(Handle, FTimerDelegate::CreateWeakLambda(this, MoveTemp(Operation)),
+		TestSimulatedLatency, false);
+}
+
+const TCHAR* USubmarineGameInstance::GetOperationName(const ESubmarineOnlineOperation Operation)
+{
+	switch (Operation)
+	{
+		case ESubmarineOnlineOperation::LogIn:
+			return TEXT("Log in");
+		case ESubmarineOnlineOperation::CreateSession:
+			return TEXT("Create session");
+		case ESubmarineOnlineOperation::FindSessions:
+			return TEXT("Find sessions");
+		case ESubmarineOnlineOperation::JoinSession:
+			return TEXT("Join session");
+		default:
+			return TEXT("None");
+	}
+}
+
+bool USubmarineGameInstance::IsOperationPending(const ESubmarineOnlineOperation Operation) const
+{
+	return CurrentOperation == Operation || OperationQueue.ContainsByPredicate(
+		[Operation](const FQueuedOnlineOperation& Queued) { return Queued.Type == Operation; });
+}
+
+bool USubmarineGameInstance::IsOperationPending(const ESubmarineOnlineOperation Operation, const FString& Key) const
+{
+	return (CurrentOperation == Operation && CurrentOperationKey == Key) || OperationQueue.ContainsByPredicate(
+		[Operation, &Key](const FQueuedOnlineOperation& Queued) { return Queued.Type == Operation && Queued.Key == Key; });
+}
+
+bool USubmarineGameInstance::EnqueueOperation(const ESubmarineOnlineOperation Operation, const float Timeout,
+	TFunction<void()>&& Start, const FString& Key)
+{
+	if (Operation == ESubmarineOnlineOperation::JoinSession)
+	{
+		if (CurrentOperation == Operation)
+		{
+			UE_LOG(LogSubmarineOnline, Warning, TEXT("Already joining a session, ignoring another join."))
+			return false;
+		}
+		// Only the most recent join request is worth making
+		OperationQueue.RemoveAll([Operation](const FQueuedOnlineOperation& Queued) { return Queued.Type == Operation; });
+	}
+	else if (IsOperationPending(Operation, Key))
+	{
+		// Whoever asked will hear about it when the identical one already pending completes
+		UE_LOG(LogSubmarineOnline, Log, TEXT("%s already pending, coalescing."), GetOperationName(Operation))
+		return true;
+	}
+	else if (Operation == ESubmarineOnlineOperation::CreateSession && IsOperationPending(Operation))
+	{
+		// Queueing it would only fail later, the backend won't create a second session while the first one exists
+		UE_LOG(LogSubmarineOnline, Warning, TEXT("A different %s is already pending, refusing %s."),
+			GetOperationName(Operation), *Key)
+		return false;
+	}
+	OperationQueue.Add({Operation, Timeout, MoveTemp(Start), Key});
+	// We can be called from inside a backend callback (e.g. the portal fallback), so same as FinishOperation
+	GetTimerManager().SetTimerForNextTick(this, &USubmarineGameInstance::StartNextOperation);
+	return true;
+}
+
+void USubmarineGameInstance::StartNextOperation()
+{
+	if (CurrentOperation != ESubmarineOnlineOperation::None || OperationQueue.Num() == 0)
+	{
+		return;
+	}
+	FQueuedOnlineOperation Next = MoveTemp(OperationQueue[0]);
+	OperationQueue.RemoveAt(0);
+	CurrentOperation = Next.Type;
+	CurrentOperationKey = Next.Key;
+	if (Next.Timeout > 0.f)
+	{
+		GetTimerManager().SetTimer(OperationTimeoutTimer, this, &USubmarineGameInstance::OnOperationTimedOut,
+			Next.Timeout, false);
+	}
+	Next.Start();
+}
+
+void USubmarineGameInstance::FinishOperation(const ESubmarineOnlineOperation Operation)
+{
+	if (OnlineSubsystem)
+	{
+		const IOnlineIdentityPtr Identity = OnlineSubsystem->GetIdentityInterface();
+		const IOnlineSessionPtr Session = OnlineSubsystem->GetSessionInterface();
+		switch (Operation)
+		{
+			case ESubmarineOnlineOperation::LogIn:
+				if (Identity && !LogInAttempts.HasPersistentInFlight())
+				{
+					Identity->ClearOnLoginCompleteDelegate_Handle(LogInUserNum, LogInCompleteHandle);
+				}
+				break;
+			case ESubmarineOnlineOperation::CreateSession:
+				if (Session)
+				{
+					Session->ClearOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteHandle);
+				}
+				break;
+			case ESubmarineOnlineOperation::FindSessions:
+				if (Session)
+				{
+					Session->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteHandle);
+				}
+				break;
+			case ESubmarineOnlineOperation::JoinSession:
+				if (Session)
+				{
+					Session->ClearOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteHandle);
+				}
+				break;
+			default:
+				break;
+		}
+	}
+	if (CurrentOperation != Operation)
+	{
+		return;
+	}
+	CurrentOperation = ESubmarineOnlineOperation::None;
+	CurrentOperationKey.Reset();
+	GetTimerManager().ClearTimer(OperationTimeoutTimer);
+	// Not from inside the backend's callback - some of them don't like being re-entered
+	GetTimerManager().SetTimerForNextTick(this, &USubmarineGameInstance::StartNextOperation);
+}
+
+void USubmarineGameInstance::OnOperationTimedOut()
+{
+	const ESubmarineOnlineOperation Operation = CurrentOperation;
+	UE_LOG(LogSubmarineOnline, Warning, TEXT("%s timed out."), GetOperationName(Operation))
+	FinishOperation(Operation);
+
+	const IOnlineSessionPtr Session = OnlineSubsystem ? OnlineSubsystem->GetSessionInterface() : nullptr;
+	switch (Operation)
+	{
+		case ESubmarineOnlineOperation::LogIn:
+			OnLogInResult(LogInUserNum, false, TEXT("Timed out"));
+			break;
+		case ESubmarineOnlineOperation::CreateSession:
+			CreateSessionsCompleted.Broadcast(false);
+			break;
+		case ESubmarineOnlineOperation::FindSessions:
+			if (Session)
+			{
+				Session->CancelFindSessions();
+			}
+			bIsSearching = false;
+			FindSessionsCompleted.Broadcast(false);
+			if (bIsQuickJoining)
+			{
+				TryNextQuickJoinCandidate();
+			}
+			break;
+		case ESubmarineOnlineOperation::JoinSession:
+			OnJoinAttemptFailed();
+			break;
+		default:
+			break;
+	}
+}
+
+void USubmarineGameInstance::CancelOnlineOperations()
+{
+	CancelQuickJoin();
+	ReleaseTravelPreload();
+	OperationQueue.Empty();
+	const ESubmarineOnlineOperation Operation = CurrentOperation;
+	if (Operation == ESubmarineOnlineOperation::None)
+	{
+		return;
+	}
+	UE_LOG(LogSubmarineOnline, Log, TEXT("Cancelling %s."), GetOperationName(Operation))
+	FinishOperation(Operation);
+	if (const IOnlineSessionPtr Session = OnlineSubsystem ? OnlineSubsystem->GetSessionInterface() : nullptr)
+	{
+		if (Operation == ESubmarineOnlineOperation::FindSessions)
+		{
+			Session->CancelFindSessions();
+		}
+		else if (Operation == ESubmarineOnlineOperation::JoinSession)
+		{
+			Session->DestroySession(NAME_GameSession);
+		}
+	}
+	bIsSearching = false;
 }
 
 void USubmarineGameInstance::LogNoSubsystem()
 {
-	UE_LOG(LogTemp, Error, TEXT("Online Subsystem not valid"))
+	UE_LOG(LogSubmarineOnline, Error, TEXT("Online Subsystem not valid"))
 }
 
 void USubmarineGameInstance::LogNoSessionInterface()
 {
-	UE_LOG(LogTemp, Error, TEXT("Failed to get Session interface."))
+	UE_LOG(LogSubmarineOnline, Error, TEXT("Failed to get Session interface."))
 }
 
 void USubmarineGameInstance::LogNoIdentityInterface()
 {
-	UE_LOG(LogTemp, Error, TEXT("Failed to get Identity interface."))
+	UE_LOG(LogSubmarineOnline, Error, TEXT("Failed to get Identity interface."))
 }
 
 bool USubmarineGameInstance::IsLoggedIn()
@@ -65,6 +463,11 @@ bool USubmarineGameInstance::IsLoggedIn()
 
 
 void USubmarineGameInstance::LogIn(const int PlayerNumber)
+{
+	StartLogIn(PlayerNumber, PersistentLogInType);
+}
+
+void USubmarineGameInstance::StartLogIn(const int PlayerNumber, const FString& LogInType)
 {
 	if (OnlineSubsystem)
 	{
@@ -75,10 +478,47 @@ void USubmarineGameInstance::LogIn(const int PlayerNumber)
 			// const auto Guid = GetUniqueID();
 			// Credentials.Id.AppendInt(Guid);
 			Credentials.Token = FString();
-			Credentials.Type = FString(LogInType);
+			Credentials.Type = LogInType;
 
-			Identity->OnLoginCompleteDelegates->AddUObject(this, &USubmarineGameInstance::OnLoginComplete);
-			Identity->Login(PlayerNumber, Credentials);
+			const bool bIsPersistent = LogInType == PersistentLogInType;
+			EnqueueOperation(ESubmarineOnlineOperation::LogIn,
+				bIsPersistent ? PersistentLogInTimeout : OnlineOperationTimeout,
+				[this, Identity, PlayerNumber, Credentials, bIsPersistent]()
+				{
+					LogInAttempts.Begin(bIsPersistent);
+					LogInStartTime = FPlatformTime::Seconds();
+					LogInUserNum = PlayerNumber;
+					if (bIsPersistent && bUseTestOnlineSubsystem && bTestPersistentLogInFails)
+					{
+						RunAfterSimulatedLatency([this, PlayerNumber]()
+						{
+							if (CurrentOperation != ESubmarineOnlineOperation::LogIn)
+							{
+								return;
+							}
+							FinishOperation(ESubmarineOnlineOperation::LogIn);
+							OnLogInResult(PlayerNumber, false, TEXT("No cached credentials (simulated)"));
+						});
+						return;
+					}
+					// Still bound if a cached log in we gave up on hasn't answered yet
+					if (!LogInCompleteHandle.IsValid())
+					{
+						LogInCompleteHandle = Identity->AddOnLoginCompleteDelegate_Handle(PlayerNumber,
+							FOnLoginCompleteDelegate::CreateUObject(this, &USubmarineGameInstance::OnLoginComplete));
+					}
+					RunAfterSimulatedLatency([this, Identity, PlayerNumber, Credentials, bIsPersistent]()
+					{
+						// Timed out before the simulated latency was up, and the portal has taken over
+						if (CurrentOperation != ESubmarineOnlineOperation::LogIn
+							|| LogInAttempts.IsTryingPersistent() != bIsPersistent)
+						{
+							return;
+						}
+						LogInAttempts.MarkSent();
+						Identity->Login(PlayerNumber, Credentials);
+					});
+				}, FString::FromInt(PlayerNumber));
 		}
 		else
 		{
@@ -94,9 +534,39 @@ void USubmarineGameInstance::LogIn(const int PlayerNumber)
 void USubmarineGameInstance::OnLoginComplete(int32 LocalUserNum, bool bWasSuccessful, const FUniqueNetId& UserId,
 	const FString& ErrorMessage)
 {
+	if (!LogInAttempts.ConsumeAnswer())
+	{
+		// The portal is what the player is looking at now, so that's the result that counts
+		UE_LOG(LogSubmarineOnline, Log, TEXT("Cached log in came back after we fell back to the portal (%s), ignoring it"),
+			bWasSuccessful ? TEXT("succeeded") : *ErrorMessage)
+		if (CurrentOperation != ESubmarineOnlineOperation::LogIn)
+		{
+			// The portal hasn't started yet and will bind its own delegate
+			FinishOperation(ESubmarineOnlineOperation::LogIn);
+		}
+		return;
+	}
+	LogOperationTime(TEXT("Log in"), LogInStartTime);
+	FinishOperation(ESubmarineOnlineOperation::LogIn);
+	OnLogInResult(LocalUserNum, bWasSuccessful, ErrorMessage);
+}
+
+void USubmarineGameInstance::OnLogInResult(const int32 LocalUserNum, const bool bWasSuccessful,
+	const FString& ErrorMessage)
+{
+	const bool bWasPersistent = LogInAttempts.IsTryingPersistent();
+	LogInAttempts.End();
+	if (!bWasSuccessful && bWasPersistent)
+	{
+		UE_LOG(LogSubmarineOnline, Log, TEXT("No usable cached log in (%s), falling back to the account portal"),
+			*ErrorMessage)
+		StartLogIn(LocalUserNum, PortalLogInType);
+		return;
+	}
+
 	if (bWasSuccessful)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Logging in successful!"))
+		UE_LOG(LogSubmarineOnline, Warning, TEXT("Logging in successful!"))
 		if (GEngine)
 		{
 			GEngine->AddOnScreenDebugMessage(-1, 3.0f, FColor::Green,
@@ -105,36 +575,28 @@ void USubmarineGameInstance::OnLoginComplete(int32 LocalUserNum, bool bWasSucces
 	}
 	else
 	{
-		UE_LOG(LogTemp, Error, TEXT("Log In Failed: %s"), *ErrorMessage);
+		UE_LOG(LogSubmarineOnline, Error, TEXT("Log In Failed: %s"), *ErrorMessage);
 		if (GEngine)
 		{
 			GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Yellow,
 				TEXT("Log in Failed... you might be able to try again, though."));	
 		}
 	}
-	
-	if (OnlineSubsystem)
-	{
-		if (const IOnlineIdentityPtr Identity = OnlineSubsystem->GetIdentityInterface())
-		{
-			Identity->ClearOnLoginCompleteDelegates(LocalUserNum, this);
-		}
-		else
-		{
-			LogNoIdentityInterface();
-		}
-	}
-	else
-	{
-		LogNoSubsystem();
-	}
 
 	LogInCompleted.Broadcast(bWasSuccessful);
 }
 
 void USubmarineGameInstance::OnFindSessionsComplete(bool bWasSuccessful)
 {
+	LLM_SCOPE_BYTAG(Submarine_Online);
 	bIsSearching = false;
+	LogOperationTime(TEXT("Find sessions"), FindSessionsStartTime);
+	FinishOperation(ESubmarineOnlineOperation::FindSessions);
+	if (bWasSuccessful && bUseTestOnlineSubsystem && TestSyntheticResults > 0)
+	{
+		FSubmarineTestOnline::AddSyntheticSearchResults(SessionSearch->SearchResults, TestSyntheticResults,
+			MakeSessionSettings("Synthetic"), SettingKeyLobbyName);
+	}
 	if (GEngine)
 	{
 		if (bWasSuccessful && SessionSearch->SearchResults.Num() == 0)
@@ -151,24 +613,41 @@ void USubmarineGameInstance::OnFindSessionsComplete(bool bWasSuccessful)
 	
 	if (bWasSuccessful)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Success! Found %d sessions!"), SessionSearch->SearchResults.Num())
+		UE_LOG(LogSubmarineOnline, Warning, TEXT("Success! Found %d sessions!"), SessionSearch->SearchResults.Num())
+		SessionBrowser->UpdateFromSearch(SessionSearch->SearchResults, SettingKeyLobbyName);
+		// Synthetic sessions have nothing to ping, so test mode sticks to the ping they came with
+		SessionBrowser->StartPingProbes(OnlineSubsystem && !bUseTestOnlineSubsystem
+			? OnlineSubsystem->GetSessionInterface() : nullptr);
 	}
 	else
 	{
-		UE_LOG(LogTemp, Error, TEXT("Session search failed."))
+		UE_LOG(LogSubmarineOnline, Error, TEXT("Session search failed."))
 	}
-	if (OnlineSubsystem)
+	FindSessionsCompleted.Broadcast(bWasSuccessful);
+
+	if (bIsQuickJoining)
 	{
-		if (const IOnlineSessionPtr Session = OnlineSubsystem->GetSessionInterface())
-		{
-			Session->ClearOnFindSessionsCompleteDelegates(this);
-		}
+		RefillQuickJoinCandidates();
+		TryNextQuickJoinCandidate();
 	}
-	FindSessionsCompleted.Broadcast(bWasSuccessful);
 }
 
 void USubmarineGameInstance::OnJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result)
 {
+	LogOperationTime(TEXT("Join session"), JoinSessionStartTime);
+	FinishOperation(ESubmarineOnlineOperation::JoinSession);
+	if (Result != EOnJoinSessionCompleteResult::Success)
+	{
+		UE_LOG(LogSubmarineOnline, Warning, TEXT("Failed to join session: %s"), LexToString(Result))
+		OnJoinAttemptFailed();
+		return;
+	}
+	JoinTimeline.Mark(ESubmarineJoinPhase::Resolved);
+	if (bIsQuickJoining)
+	{
+		FinishQuickJoin(true);
+	}
+
 	if (OnlineSubsystem)
 	{
 		if (const auto Session = OnlineSubsystem->GetSessionInterface())
@@ -177,7 +656,7 @@ void USubmarineGameInstance::OnJoinSessionComplete(FName SessionName, EOnJoinSes
 			Session->GetResolvedConnectString(SessionName, ConnectionInfo);
 			if (ConnectionInfo.IsEmpty())
 			{
-				UE_LOG(LogTemp, Error, TEXT("ConnectionInfo was empty."))
+				UE_LOG(LogSubmarineOnline, Error, TEXT("ConnectionInfo was empty."))
 				return;
 			}
 			if (APlayerController* Player = UGameplayStatics::GetPlayerController(GetWorld(), 0))
@@ -188,22 +667,98 @@ void USubmarineGameInstance::OnJoinSessionComplete(FName SessionName, EOnJoinSes
 	}
 }
 
+void USubmarineGameInstance::OnJoinAttemptFailed()
+{
+	JoinTimeline.Abandon();
+	if (bIsQuickJoining)
+	{
+		// The next candidate may well be on the same map, so the preload stays until quick join gives up
+		bIsQuickJoinAttemptInFlight = false;
+		TryNextQuickJoinCandidate();
+		return;
+	}
+	ReleaseTravelPreload();
+}
+
 int USubmarineGameInstance::GetNumSessionsFound()
 {
-	if (SessionSearch->SearchState != EOnlineAsyncTaskState::Done)
+	return SessionBrowser->GetNumSessions();
+}
+
+
+FOnlineSessionSettings USubmarineGameInstance::MakeSessionSettings(const FString& ResolvedName,
+	const bool bIsDedicated) const
+{
+	auto Settings = FOnlineSessionSettings();
+	Settings.bIsDedicated = bIsDedicated;
+	Settings.bShouldAdvertise = bAdvertise;
+	// The Null subsystem only knows how to host and find sessions over LAN
+	Settings.bIsLANMatch = bIsLan || bUseTestOnlineSubsystem;
+	Settings.NumPublicConnections = NumPlayers;
+	Settings.bAllowJoinInProgress = true;
+	Settings.bAllowJoinViaPresence = bUsePresence;
+	Settings.bUsesPresence = bUsePresence;
+	Settings.bUseLobbiesVoiceChatIfAvailable = false;
+	Settings.bUseLobbiesIfAvailable = bUseLobbies;
+	if (bIsDedicated)
 	{
-		return 0;
+		// No logged in user to attach presence or a lobby to - the server advertises itself
+		Settings.bShouldAdvertise = true;
+		Settings.bAllowJoinViaPresence = false;
+		Settings.bUsesPresence = false;
+		Settings.bUseLobbiesIfAvailable = false;
 	}
-	FOnlineSessionSearchResult Result;
-	return SessionSearch->SearchResults.Num();
+	const auto NameId = Settings.GetID(SettingKeyLobbyName);
+	Settings.Set(SettingKeyLobbyName, FOnlineSessionSetting(
+		ResolvedName,
+		EOnlineDataAdvertisementType::ViaOnlineServiceAndPing, NameId));
+	// Everything FindSessions filters on. Open slots come from NumOpenPublicConnections.
+	Settings.Set(SEARCH_KEYWORDS, SearchKeyword, EOnlineDataAdvertisementType::ViaOnlineService);
+	Settings.Set(SettingKeyBuildVersion, GetBuildVersion(), EOnlineDataAdvertisementType::ViaOnlineService);
+	Settings.Set(SettingKeyRegion, Region, EOnlineDataAdvertisementType::ViaOnlineService);
+	Settings.Set(SettingKeyGameMode, GameMode, EOnlineDataAdvertisementType::ViaOnlineService);
+	Settings.Set(SETTING_MAPNAME, MatchMapName, EOnlineDataAdvertisementType::ViaOnlineService);
+	// A dedicated server starts empty, a listen server starts with its host
+	Settings.Set(SettingKeyNumPlayers, bIsDedicated ? 0 : 1, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+	return Settings;
 }
 
+void USubmarineGameInstance::CreateDedicatedSession()
+{
+	if (!OnlineSubsystem)
+	{
+		LogNoSubsystem();
+		return;
+	}
+	if (const IOnlineSessionPtr Session = OnlineSubsystem->GetSessionInterface())
+	{
+		const auto Settings = MakeSessionSettings(DedicatedServerName, true);
+		const bool bIsQueued = EnqueueOperation(ESubmarineOnlineOperation::CreateSession, OnlineOperationTimeout,
+			[this, Session, Settings]()
+			{
+				CreateSessionCompleteHandle = Session->AddOnCreateSessionCompleteDelegate_Handle(
+					FOnCreateSessionCompleteDelegate::CreateUObject(
+						this, &USubmarineGameInstance::OnCreateSessionComplete));
+				CreateSessionStartTime = FPlatformTime::Seconds();
+				Session->CreateSession(0, NAME_GameSession, Settings);
+			}, NAME_GameSession.ToString());
+		if (!bIsQueued)
+		{
+			CreateSessionsCompleted.Broadcast(false);
+		}
+	}
+	else
+	{
+		LogNoSessionInterface();
+	}
+}
 
 void USubmarineGameInstance::CreateSession(const FString& SessionName)
 {
+	LLM_SCOPE_BYTAG(Submarine_Online);
 	if (!IsLoggedIn())
 	{
-		UE_LOG(LogTemp, Error, TEXT("Can't create Session with Presence without being logged in."))
+		UE_LOG(LogSubmarineOnline, Error, TEXT("Can't create Session with Presence without being logged in."))
 		return;
 	}
 	
@@ -211,27 +766,26 @@ void USubmarineGameInstance::CreateSession(const FString& SessionName)
 	{
 		if (const IOnlineSessionPtr Session = OnlineSubsystem->GetSessionInterface())
 		{
-			// Settings.Set(SEARCH_KEYWORDS, SearchKeyword, EOnlineDataAdvertisementType::ViaOnlineService);
 			const FString ResolvedName = SessionName.Equals("")
 				? "SubmarineGame" : SessionName;
-			auto Settings = FOnlineSessionSettings();
-			Settings.bIsDedicated = false;
-			Settings.bShouldAdvertise = bAdvertise;
-			Settings.bIsLANMatch = bIsLan;
-			Settings.NumPublicConnections = NumPlayers;
-			Settings.bAllowJoinInProgress = true;
-			Settings.bAllowJoinViaPresence = bUsePresence;
-			Settings.bUsesPresence = bUsePresence;
-			Settings.bUseLobbiesVoiceChatIfAvailable = false;
-			Settings.bUseLobbiesIfAvailable = bUseLobbies;
-			const auto NameId = Settings.GetID(SettingKeyLobbyName);
-			Settings.Set(SettingKeyLobbyName, FOnlineSessionSetting(
-				ResolvedName,
-				EOnlineDataAdvertisementType::ViaOnlineServiceAndPing, NameId));
-			
-
-			Session->OnCreateSessionCompleteDelegates.AddUObject(this, &USubmarineGameInstance::OnCreateSessionComplete);
-			Session->CreateSession(0, FName(ResolvedName), Settings);
+			const auto Settings = MakeSessionSettings(ResolvedName);
+
+			const bool bIsQueued = EnqueueOperation(ESubmarineOnlineOperation::CreateSession, OnlineOperationTimeout,
+				[this, Session, ResolvedName, Settings]()
+				{
+					CreateSessionCompleteHandle = Session->AddOnCreateSessionCompleteDelegate_Handle(
+						FOnCreateSessionCompleteDelegate::CreateUObject(
+							this, &USubmarineGameInstance::OnCreateSessionComplete));
+					CreateSessionStartTime = FPlatformTime::Seconds();
+					RunAfterSimulatedLatency([Session, ResolvedName, Settings]()
+					{
+						Session->CreateSession(0, FName(ResolvedName), Settings);
+					});
+				}, ResolvedName);
+			if (!bIsQueued)
+			{
+				CreateSessionsCompleted.Broadcast(false);
+			}
 		}
 		else
 		{
@@ -247,9 +801,10 @@ void USubmarineGameInstance::CreateSession(const FString& SessionName)
 
 void USubmarineGameInstance::FindSessions()
 {
+	LLM_SCOPE_BYTAG(Submarine_Online);
 	if (!IsLoggedIn())
 	{
-		UE_LOG(LogTemp, Error, TEXT("Must log in first!"))
+		UE_LOG(LogSubmarineOnline, Error, TEXT("Must log in first!"))
 		return;
 	}
 
@@ -257,78 +812,276 @@ void USubmarineGameInstance::FindSessions()
 	{
 		if (IOnlineSessionPtr Session = OnlineSubsystem->GetSessionInterface())
 		{
+			if (IsOperationPending(ESubmarineOnlineOperation::FindSessions))
+			{
+				// The lobby's refresh button and quick join both end up here - one search serves them all
+				return;
+			}
 			SessionSearch = MakeShareable<FOnlineSessionSearch>(new FOnlineSessionSearch());
-			//SessionSearch->QuerySettings.Set(SEARCH_KEYWORDS, SearchKeyword, EOnlineComparisonOp::Equals);
-			// if (bUseLobbies)
-			// {
-			// 	SessionSearch->QuerySettings.Set(SEARCH_LOBBIES, true, EOnlineComparisonOp::Equals);
-			// }
-			SessionSearch->MaxSearchResults = 10000;
-			SessionSearch->bIsLanQuery = bIsLan;
+			SessionSearch->MaxSearchResults = MaxSearchResults;
+			SessionSearch->bIsLanQuery = bIsLan || bUseTestOnlineSubsystem;
 			SessionSearch->QuerySettings.Set(SEARCH_LOBBIES, bUseLobbies, EOnlineComparisonOp::Equals);
 			SessionSearch->QuerySettings.Set(SEARCH_PRESENCE, bUsePresence, EOnlineComparisonOp::Equals);
-			Session->OnFindSessionsCompleteDelegates.AddUObject(this, &USubmarineGameInstance::OnFindSessionsComplete);
+			// Let the backend throw out full and incompatible sessions instead of shipping all of them to us
+			SessionSearch->QuerySettings.Set(SEARCH_KEYWORDS, SearchKeyword, EOnlineComparisonOp::Equals);
+			SessionSearch->QuerySettings.Set(SEARCH_MINSLOTSAVAILABLE, 1, EOnlineComparisonOp::GreaterThanEquals);
+			SessionSearch->QuerySettings.Set(SettingKeyBuildVersion, GetBuildVersion(), EOnlineComparisonOp::Equals);
+			if (!Region.IsEmpty())
+			{
+				SessionSearch->QuerySettings.Set(SettingKeyRegion, Region, EOnlineComparisonOp::Equals);
+			}
+			if (!GameMode.IsEmpty())
+			{
+				SessionSearch->QuerySettings.Set(SettingKeyGameMode, GameMode, EOnlineComparisonOp::Equals);
+			}
 			bIsSearching = true;
-			Session->FindSessions(0, SessionSearch.ToSharedRef());
+			EnqueueOperation(ESubmarineOnlineOperation::FindSessions, OnlineOperationTimeout,
+				[this, Session, Search = SessionSearch.ToSharedRef()]()
+				{
+					FindSessionsCompleteHandle = Session->AddOnFindSessionsCompleteDelegate_Handle(
+						FOnFindSessionsCompleteDelegate::CreateUObject(
+							this, &USubmarineGameInstance::OnFindSessionsComplete));
+					FindSessionsStartTime = FPlatformTime::Seconds();
+					RunAfterSimulatedLatency([Session, Search]()
+					{
+						Session->FindSessions(0, Search);
+					});
+				});
 		}
 	}
 }
 
 void USubmarineGameInstance::JoinSession(int SessionNumber)
 {
-	if (bIsSearching || SessionSearch->SearchResults.Num() < 1)
+	// SessionNumber is the session's ListIndex, which stays stable across refreshes
+	const FOnlineSessionSearchResult* SearchResult = SessionBrowser->FindSearchResult(SessionNumber);
+	if (bIsSearching || SearchResult == nullptr)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("No sessions to join!"))
+		UE_LOG(LogSubmarineOnline, Warning, TEXT("No session to join at index %d!"), SessionNumber)
 		return;
 	}
 
-	if (OnlineSubsystem)
+	JoinSearchResult(*SearchResult);
+}
+
+bool USubmarineGameInstance::JoinSearchResult(const FOnlineSessionSearchResult& SearchResult)
+{
+	LLM_SCOPE_BYTAG(Submarine_Online);
+	const IOnlineSessionPtr Session = OnlineSubsystem ? OnlineSubsystem->GetSessionInterface() : nullptr;
+	if (!Session.IsValid())
 	{
-		if (const IOnlineSessionPtr Session = OnlineSubsystem->GetSessionInterface())
+		LogNoSessionInterface();
+		return false;
+	}
+	if (FSubmarineTestOnline::IsSynthetic(SearchResult))
+	{
+		UE_LOG(LogSubmarineOnline, Warning, TEXT("%s is a synthetic test session, there's nothing to join"),
+			*SearchResult.GetSessionIdStr())
+		return false;
+	}
+	return EnqueueOperation(ESubmarineOnlineOperation::JoinSession, QuickJoinAttemptTimeout,
+		[this, Session, Result = SearchResult]()
 		{
-			if (SessionSearch->SearchResults.Num() > 0)
+			JoinSessionCompleteHandle = Session->AddOnJoinSessionCompleteDelegate_Handle(
+				FOnJoinSessionCompleteDelegate::CreateUObject(this, &USubmarineGameInstance::OnJoinSessionComplete));
+			JoinSessionStartTime = FPlatformTime::Seconds();
+			JoinTimeline.Begin();
+			// Start loading the match while the backend is still working out where it is
+			PrewarmTravel(Result);
+			RunAfterSimulatedLatency([Session, Result]()
 			{
-				UE_LOG(LogTemp, Warning, TEXT("%d sessions found!"), SessionSearch->SearchResults.Num())
-			}
-			Session->OnJoinSessionCompleteDelegates.AddUObject(this, &USubmarineGameInstance::OnJoinSessionComplete);
-			Session->JoinSession(0, TestSessionName, SessionSearch->SearchResults[SessionNumber]);
+				Session->JoinSession(0, NAME_GameSession, Result);
+			});
+		});
+}
+
+bool USubmarineGameInstance::JoinBestSession()
+{
+	const int BestSession = SessionBrowser->GetBestSessionIndex();
+	if (BestSession < 0)
+	{
+		UE_LOG(LogSubmarineOnline, Warning, TEXT("No joinable sessions to pick from!"))
+		return false;
+	}
+	JoinSession(BestSession);
+	return true;
+}
+
+void USubmarineGameInstance::QuickJoin()
+{
+	if (bIsQuickJoining)
+	{
+		return;
+	}
+	if (!IsLoggedIn())
+	{
+		UE_LOG(LogSubmarineOnline, Error, TEXT("Must log in before quick joining!"))
+		QuickJoinCompleted.Broadcast(false, 0.f);
+		return;
+	}
+
+	bIsQuickJoining = true;
+	bIsQuickJoinAttemptInFlight = false;
+	QuickJoinTriedSessions.Empty();
+	QuickJoinAttempts = 0;
+	QuickJoinSearches = 0;
+	QuickJoinStartTime = FPlatformTime::Seconds();
+
+	// Start on whatever the last search found - we only search once those run out
+	RefillQuickJoinCandidates();
+	TryNextQuickJoinCandidate();
+}
+
+void USubmarineGameInstance::CancelQuickJoin()
+{
+	if (!bIsQuickJoining)
+	{
+		return;
+	}
+	if (CurrentOperation == ESubmarineOnlineOperation::JoinSession)
+	{
+		FinishOperation(ESubmarineOnlineOperation::JoinSession);
+		if (const IOnlineSessionPtr Session = OnlineSubsystem ? OnlineSubsystem->GetSessionInterface() : nullptr)
+		{
+			Session->DestroySession(NAME_GameSession);
 		}
-		
 	}
+	FinishQuickJoin(false);
 }
 
-TArray<FSubmarineSession> USubmarineGameInstance::GetSearchResults()
+void USubmarineGameInstance::RefillQuickJoinCandidates()
 {
-	TArray<FSubmarineSession> Results = TArray<FSubmarineSession>();
-	for (int i = 0; i < SessionSearch->SearchResults.Num(); ++i)
-	{
-		FSubmarineSession SubmarineSession = FSubmarineSession();
-		const auto& SearchResult = SessionSearch->SearchResults[i];
-		const IOnlineSessionPtr SessionInterface = OnlineSubsystem->GetSessionInterface();
-		// TODO: Figure out how to Set/Retrieve a custom Session Name
-		// const NamedSession = SessionInterface->GetNamedSession()
-		// 
-		// if (NamedSession)
-		// {
-		// 	SubmarineSession.Name = NamedSession->SessionName.ToString();
-		// }
-		// else
-		
-		if(!SearchResult.Session.SessionSettings.Get(SettingKeyLobbyName, SubmarineSession.Name))
+	SessionBrowser->GetJoinCandidates(QuickJoinCandidates);
+	QuickJoinCandidates.RemoveAll([this](const int ListIndex)
+	{
+		return QuickJoinTriedSessions.Contains(SessionBrowser->GetSessionId(ListIndex));
+	});
+	Algo::Reverse(QuickJoinCandidates);
+}
+
+void USubmarineGameInstance::TryNextQuickJoinCandidate()
+{
+	if (!bIsQuickJoining || bIsQuickJoinAttemptInFlight)
+	{
+		return;
+	}
+	if (QuickJoinAttempts >= QuickJoinMaxAttempts)
+	{
+		FinishQuickJoin(false);
+		return;
+	}
+	const IOnlineSessionPtr Session = OnlineSubsystem ? OnlineSubsystem->GetSessionInterface() : nullptr;
+	if (!Session.IsValid())
+	{
+		LogNoSessionInterface();
+		FinishQuickJoin(false);
+		return;
+	}
+	// A failed or timed out attempt can leave its session behind, and joining again under the same name would fail
+	if (Session->GetNamedSession(NAME_GameSession) != nullptr)
+	{
+		bIsQuickJoinAttemptInFlight = true;
+		Session->DestroySession(NAME_GameSession, FOnDestroySessionCompleteDelegate::CreateWeakLambda(this,
+			[this](FName, bool)
+			{
+				bIsQuickJoinAttemptInFlight = false;
+				TryNextQuickJoinCandidate();
+			}));
+		return;
+	}
+
+	const FOnlineSessionSearchResult* SearchResult = nullptr;
+	while (SearchResult == nullptr && QuickJoinCandidates.Num() > 0)
+	{
+		const int ListIndex = QuickJoinCandidates.Pop(false);
+		FSubmarineSession Candidate;
+		// The browser may have refreshed since the queue was built
+		if (SessionBrowser->GetSession(ListIndex, Candidate) && Candidate.CanJoin()
+			&& !QuickJoinTriedSessions.Contains(SessionBrowser->GetSessionId(ListIndex)))
+		{
+			SearchResult = SessionBrowser->FindSearchResult(ListIndex);
+		}
+	}
+	if (SearchResult == nullptr)
+	{
+		// Out of candidates - wait for the running search, or run another one
+		if (bIsSearching)
+		{
+			return;
+		}
+		if (QuickJoinSearches < QuickJoinMaxSearches)
+		{
+			ScheduleQuickJoinSearch();
+		}
+		else
+		{
+			FinishQuickJoin(false);
+		}
+		return;
+	}
+
+	QuickJoinTriedSessions.Add(SearchResult->GetSessionIdStr());
+	++QuickJoinAttempts;
+	bIsQuickJoinAttemptInFlight = true;
+	if (!JoinSearchResult(*SearchResult))
+	{
+		// Someone else's join got there first
+		FinishQuickJoin(false);
+	}
+}
+
+void USubmarineGameInstance::ScheduleQuickJoinSearch()
+{
+	if (QuickJoinSearches == 0)
+	{
+		++QuickJoinSearches;
+		FindSessions();
+		return;
+	}
+	const float Delay = QuickJoinRetryDelay * FMath::Pow(2.f, QuickJoinSearches - 1);
+	UE_LOG(LogSubmarineOnline, Log, TEXT("Quick join ran out of sessions, searching again in %.1fs"), Delay)
+	GetTimerManager().SetTimer(QuickJoinTimer, FTimerDelegate::CreateWeakLambda(this, [this]()
+	{
+		if (bIsQuickJoining && !bIsSearching)
 		{
-			UE_LOG(LogTemp, Warning, TEXT("Failed to fetch Session name."))
+			++QuickJoinSearches;
+			FindSessions();
 		}
-		SubmarineSession.NumPlayers = 12 - SearchResult.Session.NumOpenPublicConnections;
-		SubmarineSession.ListIndex = i;
-		Results.Add(SubmarineSession);
+	}), Delay, false);
+}
+
+void USubmarineGameInstance::FinishQuickJoin(const bool bWasSuccessful)
+{
+	bIsQuickJoining = false;
+	bIsQuickJoinAttemptInFlight = false;
+	QuickJoinCandidates.Empty();
+	GetTimerManager().ClearTimer(QuickJoinTimer);
+	if (!bWasSuccessful)
+	{
+		// Not going anywhere, so don't keep the arena resident
+		ReleaseTravelPreload();
 	}
-	return Results;
+
+	const float SecondsToMatch = FPlatformTime::Seconds() - QuickJoinStartTime;
+	UE_LOG(LogSubmarineOnline, Log, TEXT("Quick join %s after %.2fs, %d attempts and %d searches"),
+		bWasSuccessful ? TEXT("succeeded") : TEXT("gave up"), SecondsToMatch, QuickJoinAttempts, QuickJoinSearches)
+	QuickJoinCompleted.Broadcast(bWasSuccessful, SecondsToMatch);
+}
+
+TArray<FSubmarineSession> USubmarineGameInstance::GetSearchResults()
+{
+	return SessionBrowser->GetSessions();
 }
 
 
 void USubmarineGameInstance::OnCreateSessionComplete(FName SessionName, bool bWasSuccessful)
 {
-	UE_LOG(LogTemp, Warning, TEXT("Create Session %s Succeeded: %d"), *SessionName.ToString(), bWasSuccessful);
+	UE_LOG(LogSubmarineOnline, Warning, TEXT("Create Session %s Succeeded: %d"), *SessionName.ToString(), bWasSuccessful);
+	LogOperationTime(TEXT("Create session"), CreateSessionStartTime);
+	if (bWasSuccessful)
+	{
+		HostedSessionName = SessionName;
+	}
 
 	if (GEngine && !bWasSuccessful)
 	{
@@ -343,7 +1096,7 @@ void USubmarineGameInstance::OnCreateSessionComplete(FName SessionName, bool bWa
 	}
 	if (const IOnlineSessionPtr Session = OnlineSubsystem->GetSessionInterface())
 	{
-		Session->ClearOnCreateSessionCompleteDelegates(this);
+		FinishOperation(ESubmarineOnlineOperation::CreateSession);
 	}
 	else
 	{
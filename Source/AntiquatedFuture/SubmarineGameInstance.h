@@ -6,43 +6,165 @@
 #include "OnlineSessionSettings.h"
 #include "Engine/GameInstance.h"
 #include "Interfaces/OnlineSessionInterface.h"
+#include "SubmarineJoinTimeline.h"
+#include "SubmarineLogInAttempts.h"
 #include "SubmarineGameInstance.generated.h"
 
 struct FSubmarineSession;
+struct FStreamableHandle;
+class AGameModeBase;
+class USubmarineSessionBrowser;
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FLoginComplete, bool, bWasSuccessful);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FCreateSessionComplete, bool, bWasSuccessful);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FFindSessionsComplete, bool, bWasSuccessful);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FQuickJoinComplete, bool, bWasSuccessful, float, SecondsToMatch);
+
+enum class ESubmarineOnlineOperation : uint8
+{
+	None,
+	LogIn,
+	CreateSession,
+	FindSessions,
+	JoinSession
+};
 
 /**
  * 
  */
-UCLASS()
+UCLASS(Config=Game)
 class ANTIQUATEDFUTURE_API USubmarineGameInstance : public UGameInstance
 {
 	GENERATED_BODY()
 
-	const FString LogInType = "accountportal";
+	// The refresh token saved by the last successful log in gets us through without any UI, so that goes first
+	const FString PersistentLogInType = "persistentauth";
+	const FString PortalLogInType = "accountportal";
 	const FString SearchKeyword = "SubmarineTest";
 	const FName SettingKeyLobbyName = "SubmarineLobbyName";
-	const FName TestSessionName = FName("Submarine Session");
+	const FName SettingKeyBuildVersion = "SubmarineBuildVersion";
+	const FName SettingKeyRegion = "SubmarineRegion";
+	const FName SettingKeyGameMode = "SubmarineGameMode";
+	const FName SettingKeyNumPlayers = "SubmarineNumPlayers";
 	
 protected:
 	class IOnlineSubsystem* OnlineSubsystem;
 	TSharedPtr<class FOnlineSessionSearch> SessionSearch;
 
+	// Runs on the Null subsystem instead of Steam/EOS (see FSubmarineTestOnline). Also enabled by -SubmarineTestOnline.
+	UPROPERTY(Config)
+	bool bUseTestOnlineSubsystem;
+	// Extra delay before every backend call in test mode, to stand in for a real service's round trip
+	UPROPERTY(Config)
+	float TestSimulatedLatency;
+	// Made up sessions added to every search in test mode. They show up in the list but can never be joined.
+	UPROPERTY(Config)
+	int32 TestSyntheticResults;
+
+	// Log in as soon as the game starts instead of waiting for the menu to ask
+	UPROPERTY(Config)
+	bool bLogInOnStartup;
+	// Test mode only: pretend there's no cached credential so the portal fallback gets exercised
+	UPROPERTY(Config)
+	bool bTestPersistentLogInFails;
+	// Whether we're on the cached log in or the portal, and which answers are left over from cached ones we gave up on
+	FSubmarineLogInAttempts LogInAttempts;
+
+	// When each operation was requested, so we can log how long the whole round trip took
+	double LogInStartTime = 0.0;
+	double CreateSessionStartTime = 0.0;
+	double FindSessionsStartTime = 0.0;
+	double JoinSessionStartTime = 0.0;
+
+	// Online operations run one at a time. Each one binds its completion delegate when it starts and unbinds it when
+	// it finishes or times out, so callbacks can never stack up.
+	struct FQueuedOnlineOperation
+	{
+		ESubmarineOnlineOperation Type;
+		float Timeout;
+		TFunction<void()> Start;
+		// What exactly was asked for (e.g. the session name, the player logging in). Only identical requests are coalesced.
+		FString Key;
+	};
+	TArray<FQueuedOnlineOperation> OperationQueue;
+	ESubmarineOnlineOperation CurrentOperation = ESubmarineOnlineOperation::None;
+	FString CurrentOperationKey;
+	FTimerHandle OperationTimeoutTimer;
+	int32 LogInUserNum = 0;
+	FDelegateHandle LogInCompleteHandle;
+	FDelegateHandle CreateSessionCompleteHandle;
+	FDelegateHandle FindSessionsCompleteHandle;
+	FDelegateHandle JoinSessionCompleteHandle;
+
+	// Where the time between "Join" and controlling a submarine goes
+	FSubmarineJoinTimeline JoinTimeline;
+	// Keeps the match map resident from the moment we decide to join until it's been loaded for real
+	TSharedPtr<FStreamableHandle> TravelPreloadHandle;
+	FSoftObjectPath TravelPreloadPath;
+	FDelegateHandle PreLoadMapHandle;
+	FDelegateHandle PostLoadMapHandle;
+
+	// The session we're hosting, if any. Joins and leaves are batched into one UpdateSession per interval.
+	FName HostedSessionName;
+	FTimerHandle OccupancyUpdateTimer;
+	FDelegateHandle PostLoginHandle;
+	FDelegateHandle LogoutHandle;
+
+	// Quick join works through the browser's ranked candidates, best first (the back of the array)
+	bool bIsQuickJoining = false;
+	bool bIsQuickJoinAttemptInFlight = false;
+	TArray<int> QuickJoinCandidates;
+	TSet<FString> QuickJoinTriedSessions;
+	int QuickJoinAttempts = 0;
+	int QuickJoinSearches = 0;
+	double QuickJoinStartTime = 0.0;
+	FTimerHandle QuickJoinTimer;
+
+	static const TCHAR* GetOperationName(const ESubmarineOnlineOperation Operation);
+	bool IsOperationPending(const ESubmarineOnlineOperation Operation) const;
+	bool IsOperationPending(const ESubmarineOnlineOperation Operation, const FString& Key) const;
+	// Returns false if the request was refused, because a different session is already being created
+	bool EnqueueOperation(const ESubmarineOnlineOperation Operation, const float Timeout, TFunction<void()>&& Start,
+		const FString& Key = FString());
+	void StartNextOperation();
+	void FinishOperation(const ESubmarineOnlineOperation Operation);
+	void OnOperationTimedOut();
+	void OnJoinAttemptFailed();
+	bool JoinSearchResult(const FOnlineSessionSearchResult& SearchResult);
+	void PrewarmTravel(const FOnlineSessionSearchResult& SearchResult);
+	void ReleaseTravelPreload();
+	void OnPreLoadMap(const FString& MapName);
+	void OnPostLoadMap(UWorld* LoadedWorld);
+	void OnGameModePostLogin(AGameModeBase* GameModeBase, APlayerController* NewPlayer);
+	void OnGameModeLogout(AGameModeBase* GameModeBase, AController* Exiting);
+	void ScheduleOccupancyUpdate();
+	void PushOccupancyUpdate();
+
 	static void LogNoSubsystem();
 	static void LogNoSessionInterface();
 	static void LogNoIdentityInterface();
+	static int32 GetBuildVersion();
+	static void LogOperationTime(const TCHAR* Operation, const double StartTime);
+	FOnlineSessionSettings MakeSessionSettings(const FString& ResolvedName, const bool bIsDedicated = false) const;
+	void CreateDedicatedSession();
+	void RunAfterSimulatedLatency(TFunction<void()>&& Operation);
 	void OnCreateSessionComplete(FName SessionName, bool bWasSuccessful);
+	void StartLogIn(const int PlayerNumber, const FString& LogInType);
 	void OnLoginComplete(
 		int32 LocalUserNum, bool bWasSuccessful, const FUniqueNetId& UserId, const FString& ErrorMessage);
+	void OnLogInResult(const int32 LocalUserNum, const bool bWasSuccessful, const FString& ErrorMessage);
 	void OnFindSessionsComplete(bool bWasSuccessful);
 	void OnJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result);
+	void RefillQuickJoinCandidates();
+	void TryNextQuickJoinCandidate();
+	void ScheduleQuickJoinSearch();
+	void FinishQuickJoin(const bool bWasSuccessful);
 
 public:
 	USubmarineGameInstance();
 	
 	virtual void Init() override;
+	virtual void OnStart() override;
+	virtual void Shutdown() override;
 
 	UPROPERTY(BlueprintReadOnly)
 	bool bIsSearching;
@@ -56,6 +178,43 @@ public:
 	bool bUsePresence;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	bool bUseLobbies;
+	// Advertised when hosting and required when searching. Leave empty to search every region.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FString Region;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FString GameMode;
+	// The backend does the filtering, so we only need enough results to fill the lobby list
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int MaxSearchResults;
+	// How long log in, create and find may take before we give up on them
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float OnlineOperationTimeout;
+	// The cached log in needs no UI, so if it's this slow we'd rather show the account portal than keep waiting
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float PersistentLogInTimeout;
+	// How long a single join may take before we give up on that session (and quick join tries the next one)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float QuickJoinAttemptTimeout;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int QuickJoinMaxAttempts;
+	// Searches run again when we run out of candidates, waiting twice as long each time
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int QuickJoinMaxSearches;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float QuickJoinRetryDelay;
+	// Most often a host re-advertises how many players it has
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float OccupancyUpdateInterval;
+	// Advertised by hosts, and what joining clients start loading before the server tells them to
+	UPROPERTY(Config, EditAnywhere)
+	FString MatchMapName;
+	// What a dedicated server shows up as in the lobby list
+	UPROPERTY(Config, EditAnywhere)
+	FString DedicatedServerName;
+
+	// Persists across searches so the lobby screen doesn't rebuild everything on each refresh
+	UPROPERTY(BlueprintReadOnly)
+	TObjectPtr<USubmarineSessionBrowser> SessionBrowser;
 	
 	UFUNCTION(BlueprintCallable)
 	int GetNumSessionsFound();
@@ -71,15 +230,32 @@ public:
 	void FindSessions();
 	UFUNCTION(BlueprintCallable)
 	void JoinSession(int SessionNumber);
+	// Joins whichever session the browser ranks best (lowest ping, then fullest)
+	UFUNCTION(BlueprintCallable)
+	bool JoinBestSession();
+	// One call from "Play" to being in a match: tries sessions in ranked order until one works, searching when it runs out
+	UFUNCTION(BlueprintCallable)
+	void QuickJoin();
+	UFUNCTION(BlueprintCallable)
+	void CancelQuickJoin();
+	UFUNCTION(BlueprintCallable)
+	bool IsQuickJoining() const { return bIsQuickJoining; }
+	// Drops everything queued and abandons whatever the backend is working on
+	UFUNCTION(BlueprintCallable)
+	void CancelOnlineOperations();
 
 	UFUNCTION(BlueprintCallable)
 	TArray<FSubmarineSession> GetSearchResults();
 
+	void MarkJoinPhase(const ESubmarineJoinPhase Phase) { JoinTimeline.Mark(Phase); }
+
 	UPROPERTY(BlueprintAssignable)
 	FLoginComplete LogInCompleted;
 	UPROPERTY(BlueprintAssignable)
 	FFindSessionsComplete FindSessionsCompleted;
 	UPROPERTY(BlueprintAssignable)
 	FCreateSessionComplete CreateSessionsCompleted;
+	UPROPERTY(BlueprintAssignable)
+	FQuickJoinComplete QuickJoinCompleted;
 	
 };
@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SubmarineHitStream.h"
+#include "AntiquatedFuture.h"
+#include "SubmarineNetStats.h"
+#include "NiagaraComponent.h"
+#include "NiagaraFunctionLibrary.h"
+#include "SubmarineProjectile.h"
+#include "Engine/NetDriver.h"
+#include "GameFramework/GameStateBase.h"
+#include "Net/UnrealNetwork.h"
+
+namespace
+{
+	int64 MeasureHitEventBits(FSubmarineHitEvent HitEvent)
+	{
+		return FSubmarineNetStats::MeasureBits([&HitEvent](FArchive& Ar)
+		{
+			bool bOutSuccess;
+			HitEvent.Location.NetSerialize(Ar, nullptr, bOutSuccess);
+			HitEvent.Normal.NetSerialize(Ar, nullptr, bOutSuccess);
+			Ar << HitEvent.Timestamp;
+			// Stands in for the projectile class' NetGUID, which we can't serialize without a package map
+			uint32 ClassGuid = 0;
+			Ar << ClassGuid;
+		});
+	}
+}
+
+void FSubmarineHitEvent::PostReplicatedAdd(const FSubmarineHitEventArray& InArraySerializer)
+{
+	LLM_SCOPE_BYTAG(Submarine_Projectile);
+	if (FSubmarineNetStats::IsEnabled())
+	{
+		const UNetDriver* NetDriver = InArraySerializer.Owner ? InArraySerializer.Owner->GetNetDriver() : nullptr;
+		FSubmarineNetStats::Record(ESubmarineNetStat::HitEvent, false, MeasureHitEventBits(*this),
+			NetDriver ? NetDriver->ServerConnection : nullptr);
+	}
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->PlayHitEffects(*this);
+	}
+}
+
+ASubmarineHitStream::ASubmarineHitStream()
+{
+	PrimaryActorTick.bCanEverTick = false;
+	bReplicates = true;
+	bAlwaysRelevant = true;
+	AActor::SetReplicateMovement(false);
+	SetHidden(true);
+}
+
+void ASubmarineHitStream::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+	DOREPLIFETIME(ASubmarineHitStream, HitEvents);
+}
+
+void ASubmarineHitStream::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+	HitEvents.Owner = this;
+}
+
+float ASubmarineHitStream::Now() const
+{
+	const auto GameState = GetWorld()->GetGameState();
+	return GameState ? GameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+}
+
+void ASubmarineHitStream::AddHit(const FVector& Location, const FVector& Normal,
+	TSubclassOf<ASubmarineProjectile> ProjectileClass)
+{
+	LLM_SCOPE_BYTAG(Submarine_Projectile);
+	if (HitEvents.Items.Num() >= MaxEvents)
+	{
+		// Oldest events are at the front
+		HitEvents.Items.RemoveAt(0, HitEvents.Items.Num() - MaxEvents + 1, false);
+		HitEvents.MarkArrayDirty();
+	}
+	FSubmarineHitEvent& HitEvent = HitEvents.Items.AddDefaulted_GetRef();
+	HitEvent.Location = Location;
+	HitEvent.Normal = Normal;
+	HitEvent.ProjectileClass = ProjectileClass;
+	HitEvent.Timestamp = Now();
+	HitEvents.MarkItemDirty(HitEvent);
+	if (FSubmarineNetStats::IsEnabled())
+	{
+		FSubmarineNetStats::RecordToRelevantConnections(ESubmarineNetStat::HitEvent, MeasureHitEventBits(HitEvent), this,
+			false);
+	}
+
+	// The Listen Server's player needs to see hits too, but nothing gets replicated to ourselves
+	if (GetNetMode() != NM_DedicatedServer)
+	{
+		PlayHitEffects(HitEvent);
+	}
+}
+
+void ASubmarineHitStream::PlayHitEffects(const FSubmarineHitEvent& HitEvent) const
+{
+	LLM_SCOPE_BYTAG(Submarine_Projectile);
+	if (Now() - HitEvent.Timestamp > MaxEventAge || HitEvent.ProjectileClass == nullptr)
+	{
+		return;
+	}
+	const auto ProjectileDefaultObject = HitEvent.ProjectileClass->GetDefaultObject<ASubmarineProjectile>();
+	if (UNiagaraSystem* HitSystem = ProjectileDefaultObject->GetHitParticleSystem())
+	{
+		UNiagaraFunctionLibrary::SpawnSystemAtLocation(GetWorld(), HitSystem, HitEvent.Location,
+			HitEvent.Normal.Rotation());
+	}
+}
@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "SubmarineHitStream.generated.h"
+
+class ASubmarineHitStream;
+class ASubmarineProjectile;
+
+USTRUCT()
+struct FSubmarineHitEvent : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FVector_NetQuantize Location;
+
+	UPROPERTY()
+	FVector_NetQuantizeNormal Normal;
+
+	// Tells Clients which hit effects to play
+	UPROPERTY()
+	TSubclassOf<ASubmarineProjectile> ProjectileClass;
+
+	// Server time the hit was resolved, so late joiners don't replay old hits
+	UPROPERTY()
+	float Timestamp = 0.f;
+
+	void PostReplicatedAdd(const struct FSubmarineHitEventArray& InArraySerializer);
+};
+
+USTRUCT()
+struct FSubmarineHitEventArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FSubmarineHitEvent> Items;
+
+	// Not replicated - just lets items find their way back to the actor that owns them
+	ASubmarineHitStream* Owner = nullptr;
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FastArrayDeltaSerialize<FSubmarineHitEvent, FSubmarineHitEventArray>(Items, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FSubmarineHitEventArray> : public TStructOpsTypeTraitsBase2<FSubmarineHitEventArray>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+/**
+ * One always-relevant actor per match that carries every resolved hit to Clients as a compact event list, so
+ * individual projectiles never need a live channel just to show where they landed.
+ */
+UCLASS(NotBlueprintable)
+class ANTIQUATEDFUTURE_API ASubmarineHitStream : public AActor
+{
+	GENERATED_BODY()
+
+	// Clients only need recent history; anything older has either been delivered or is too late to matter
+	const int32 MaxEvents = 64;
+	const float MaxEventAge = 0.5f;
+
+public:
+	ASubmarineHitStream();
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	virtual void PostInitializeComponents() override;
+
+	UPROPERTY(Replicated)
+	FSubmarineHitEventArray HitEvents;
+
+	// Server only
+	void AddHit(const FVector& Location, const FVector& Normal, TSubclassOf<ASubmarineProjectile> ProjectileClass);
+	void PlayHitEffects(const FSubmarineHitEvent& HitEvent) const;
+	float Now() const;
+};
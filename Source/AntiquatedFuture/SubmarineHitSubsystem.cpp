@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SubmarineHitSubsystem.h"
+#include "AntiquatedFuture.h"
+#include "SubmarineHitStream.h"
+#include "SubmarineProjectile.h"
+#include "GameFramework/DamageType.h"
+#include "Kismet/GameplayStatics.h"
+
+bool USubmarineHitSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId USubmarineHitSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USubmarineHitSubsystem, STATGROUP_Tickables);
+}
+
+void USubmarineHitSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+	// Clients receive the Server's stream through replication
+	if (InWorld.GetNetMode() != NM_Client)
+	{
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		HitStream = InWorld.SpawnActor<ASubmarineHitStream>(SpawnParameters);
+	}
+}
+
+void USubmarineHitSubsystem::QueueHit(ASubmarineProjectile* Projectile, AActor* Victim, const FHitResult& Hit)
+{
+	LLM_SCOPE_BYTAG(Submarine_Projectile);
+	PendingHits.Add({Projectile, Victim, Hit});
+}
+
+void USubmarineHitSubsystem::Tick(float DeltaTime)
+{
+	if (PendingHits.Num() > 0)
+	{
+		ResolveHits();
+	}
+}
+
+void USubmarineHitSubsystem::ResolveHits()
+{
+	LLM_SCOPE_BYTAG(Submarine_Projectile);
+	for (const auto& PendingHit: PendingHits)
+	{
+		ASubmarineProjectile* Projectile = PendingHit.Projectile.Get();
+		// A projectile can hit more than one thing in a frame, but only the first one counts
+		if (Projectile == nullptr || Projectile->IsActorBeingDestroyed())
+		{
+			continue;
+		}
+		APawn* Shooter = Projectile->GetInstigator();
+		AActor* Victim = PendingHit.Victim.Get();
+		if (Victim && Victim != Shooter && Victim->CanBeDamaged())
+		{
+			UGameplayStatics::ApplyPointDamage(Victim, Projectile->GetBaseDamage(),
+				Projectile->GetVelocity().GetSafeNormal(), PendingHit.Hit,
+				Shooter ? Shooter->GetController() : nullptr, Projectile, UDamageType::StaticClass());
+		}
+		if (HitStream)
+		{
+			HitStream->AddHit(PendingHit.Hit.ImpactPoint, PendingHit.Hit.ImpactNormal, Projectile->GetClass());
+		}
+		Projectile->Destroy();
+	}
+	PendingHits.Reset();
+}
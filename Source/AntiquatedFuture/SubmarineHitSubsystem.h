@@ -0,0 +1,43 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SubmarineHitSubsystem.generated.h"
+
+class ASubmarineHitStream;
+class ASubmarineProjectile;
+
+/**
+ * Server-side hit pipeline. Projectiles queue their impacts while they move, and every queued hit is resolved in one
+ * batch per frame - damage is applied and the result is pushed to ASubmarineHitStream for Clients.
+ */
+UCLASS()
+class ANTIQUATEDFUTURE_API USubmarineHitSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+	struct FPendingHit
+	{
+		TWeakObjectPtr<ASubmarineProjectile> Projectile;
+		TWeakObjectPtr<AActor> Victim;
+		FHitResult Hit;
+	};
+
+	TArray<FPendingHit> PendingHits;
+
+	UPROPERTY()
+	TObjectPtr<ASubmarineHitStream> HitStream;
+
+	void ResolveHits();
+
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	void QueueHit(ASubmarineProjectile* Projectile, AActor* Victim, const FHitResult& Hit);
+};
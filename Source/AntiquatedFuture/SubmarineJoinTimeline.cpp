@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SubmarineJoinTimeline.h"
+#include "AntiquatedFuture.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+void FSubmarineJoinTimeline::Begin()
+{
+	bIsActive = true;
+	for (double& PhaseTime: PhaseTimes)
+	{
+		PhaseTime = -1.0;
+	}
+	PhaseTimes[static_cast<int32>(ESubmarineJoinPhase::Requested)] = FPlatformTime::Seconds();
+}
+
+void FSubmarineJoinTimeline::Mark(const ESubmarineJoinPhase Phase)
+{
+	double& PhaseTime = PhaseTimes[static_cast<int32>(Phase)];
+	if (!bIsActive || PhaseTime >= 0.0)
+	{
+		return;
+	}
+	PhaseTime = FPlatformTime::Seconds();
+	if (Phase == ESubmarineJoinPhase::FirstMovement)
+	{
+		Report();
+		bIsActive = false;
+	}
+}
+
+void FSubmarineJoinTimeline::Abandon()
+{
+	bIsActive = false;
+}
+
+const TCHAR* FSubmarineJoinTimeline::GetPhaseName(const ESubmarineJoinPhase Phase)
+{
+	switch (Phase)
+	{
+		case ESubmarineJoinPhase::Requested:
+			return TEXT("Requested");
+		case ESubmarineJoinPhase::Resolved:
+			return TEXT("Resolved");
+		case ESubmarineJoinPhase::Connected:
+			return TEXT("Connected");
+		case ESubmarineJoinPhase::MapLoaded:
+			return TEXT("MapLoaded");
+		case ESubmarineJoinPhase::Possessed:
+			return TEXT("Possessed");
+		case ESubmarineJoinPhase::FirstMovement:
+			return TEXT("FirstMovement");
+		default:
+			return TEXT("Unknown");
+	}
+}
+
+void FSubmarineJoinTimeline::Report() const
+{
+	const double StartTime = PhaseTimes[static_cast<int32>(ESubmarineJoinPhase::Requested)];
+	double PreviousTime = StartTime;
+	FString Header = TEXT("Timestamp");
+	FString Row = FDateTime::Now().ToString();
+	for (int32 i = 1; i < static_cast<int32>(ESubmarineJoinPhase::Num); ++i)
+	{
+		const auto Phase = static_cast<ESubmarineJoinPhase>(i);
+		Header += FString::Printf(TEXT(",%sMs"), GetPhaseName(Phase));
+		// A phase we never saw (e.g. possession replicated before the map finished loading) shows up as -1
+		if (PhaseTimes[i] < 0.0)
+		{
+			UE_LOG(LogSubmarineOnline, Log, TEXT("Join %s: missed"), GetPhaseName(Phase))
+			Row += TEXT(",-1");
+			continue;
+		}
+		const double PhaseMs = (PhaseTimes[i] - PreviousTime) * 1000.0;
+		UE_LOG(LogSubmarineOnline, Log, TEXT("Join %s: +%.1f ms"), GetPhaseName(Phase), PhaseMs)
+		Row += FString::Printf(TEXT(",%.1f"), PhaseMs);
+		PreviousTime = PhaseTimes[i];
+	}
+	UE_LOG(LogSubmarineOnline, Log, TEXT("Join to first control took %.1f ms"), (PreviousTime - StartTime) * 1000.0)
+
+	const FString CsvPath = FPaths::ProfilingDir() / TEXT("JoinTimeline.csv");
+	if (!IFileManager::Get().FileExists(*CsvPath))
+	{
+		FFileHelper::SaveStringToFile(Header + LINE_TERMINATOR, *CsvPath);
+	}
+	FFileHelper::SaveStringToFile(Row + LINE_TERMINATOR, *CsvPath, FFileHelper::EEncodingOptions::AutoDetect,
+		&IFileManager::Get(), FILEWRITE_Append);
+}
@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+enum class ESubmarineJoinPhase : uint8
+{
+	Requested,
+	// JoinSession came back with a connect string
+	Resolved,
+	// The server accepted us and told us which map to load
+	Connected,
+	MapLoaded,
+	Possessed,
+	// First movement update sent to the server, i.e. the player is actually in control
+	FirstMovement,
+	Num
+};
+
+/**
+ * How long each step between clicking "Join" and being in control of a submarine took. Reported to the log and appended
+ * to Saved/Profiling/JoinTimeline.csv once the first movement update goes out.
+ */
+struct ANTIQUATEDFUTURE_API FSubmarineJoinTimeline
+{
+	void Begin();
+	void Mark(const ESubmarineJoinPhase Phase);
+	void Abandon();
+	bool IsActive() const { return bIsActive; }
+
+private:
+	bool bIsActive = false;
+	double PhaseTimes[static_cast<int32>(ESubmarineJoinPhase::Num)];
+
+	void Report() const;
+	static const TCHAR* GetPhaseName(const ESubmarineJoinPhase Phase);
+};
@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SubmarineLogInAttempts.h"
+
+void FSubmarineLogInAttempts::Begin(const bool bIsPersistent)
+{
+	bIsTryingPersistent = bIsPersistent;
+	bIsCurrentSent = false;
+}
+
+void FSubmarineLogInAttempts::MarkSent()
+{
+	bIsCurrentSent = true;
+	// Portal answers are always for the current attempt, only cached ones can go stale
+	if (bIsTryingPersistent)
+	{
+		++NumPersistentInFlight;
+	}
+}
+
+void FSubmarineLogInAttempts::End()
+{
+	bIsTryingPersistent = false;
+	bIsCurrentSent = false;
+}
+
+bool FSubmarineLogInAttempts::ConsumeAnswer()
+{
+	const bool bIsWaitingOnPersistent = bIsTryingPersistent && bIsCurrentSent;
+	// Anything in flight ahead of our own cached log in is older, and answers first
+	const bool bIsStale = NumPersistentInFlight > (bIsWaitingOnPersistent ? 1 : 0);
+	if (NumPersistentInFlight > 0 && (bIsStale || bIsWaitingOnPersistent))
+	{
+		--NumPersistentInFlight;
+	}
+	return !bIsStale;
+}
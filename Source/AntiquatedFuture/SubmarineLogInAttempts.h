@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Which log in attempt an OnLoginComplete belongs to. The cached log in gets a short timeout before the portal takes
+ * over, but its request is still out there and answers through the same delegate. Answers come back in the order they
+ * were asked for, so while one we gave up on is outstanding, the next answer is that one's.
+ */
+struct ANTIQUATEDFUTURE_API FSubmarineLogInAttempts
+{
+	// A new attempt is starting. Identity->Login may not have been called for it yet.
+	void Begin(const bool bIsPersistent);
+	// Identity->Login has been called for the current attempt
+	void MarkSent();
+	// Nothing is being tried any more, though old cached log ins may still answer
+	void End();
+	// Returns false if the answer is a cached log in we stopped waiting for, rather than the current attempt's
+	bool ConsumeAnswer();
+
+	bool IsTryingPersistent() const { return bIsTryingPersistent; }
+	// The log in delegate has to stay bound until every cached log in we sent has answered
+	bool HasPersistentInFlight() const { return NumPersistentInFlight > 0; }
+
+private:
+	bool bIsTryingPersistent = false;
+	bool bIsCurrentSent = false;
+	// Cached log ins sent and not answered yet, the current attempt's included
+	int32 NumPersistentInFlight = 0;
+};
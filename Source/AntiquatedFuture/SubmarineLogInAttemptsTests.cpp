@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SubmarineLogInAttempts.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	constexpr uint32 LogInTestFlags =
+		EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSubmarineLogInCachedAnswersTest, "AntiquatedFuture.Online.LogIn.CachedAnswers",
+	LogInTestFlags)
+
+bool FSubmarineLogInCachedAnswersTest::RunTest(const FString& Parameters)
+{
+	FSubmarineLogInAttempts Attempts;
+	Attempts.Begin(true);
+	Attempts.MarkSent();
+	TestTrue(TEXT("Cached log in answering in time is the current attempt"), Attempts.ConsumeAnswer());
+	TestFalse(TEXT("Nothing left in flight"), Attempts.HasPersistentInFlight());
+
+	Attempts.End();
+	Attempts.Begin(false);
+	Attempts.MarkSent();
+	TestTrue(TEXT("Portal answer with nothing else out is the current attempt"), Attempts.ConsumeAnswer());
+	TestFalse(TEXT("Portal answers are never kept in flight"), Attempts.HasPersistentInFlight());
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSubmarineLogInLateCachedAnswerTest,
+	"AntiquatedFuture.Online.LogIn.LateCachedAnswer", LogInTestFlags)
+
+bool FSubmarineLogInLateCachedAnswerTest::RunTest(const FString& Parameters)
+{
+	// The cached log in times out, and the portal goes out straight away (no simulated latency)
+	FSubmarineLogInAttempts Attempts;
+	Attempts.Begin(true);
+	Attempts.MarkSent();
+	TestTrue(TEXT("Timed out cached log in keeps the delegate bound"), Attempts.HasPersistentInFlight());
+	Attempts.End();
+	Attempts.Begin(false);
+	Attempts.MarkSent();
+	TestTrue(TEXT("Sending the portal doesn't forget the cached log in"), Attempts.HasPersistentInFlight());
+
+	TestFalse(TEXT("Late cached answer is ignored"), Attempts.ConsumeAnswer());
+	TestFalse(TEXT("Nothing cached left in flight"), Attempts.HasPersistentInFlight());
+	TestTrue(TEXT("The portal's own answer still counts"), Attempts.ConsumeAnswer());
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSubmarineLogInLateAnswerBeforePortalTest,
+	"AntiquatedFuture.Online.LogIn.LateAnswerBeforePortalSent", LogInTestFlags)
+
+bool FSubmarineLogInLateAnswerBeforePortalTest::RunTest(const FString& Parameters)
+{
+	FSubmarineLogInAttempts Attempts;
+	Attempts.Begin(true);
+	Attempts.MarkSent();
+	Attempts.End();
+	// Portal queued, but still waiting on simulated latency
+	Attempts.Begin(false);
+	TestFalse(TEXT("Cached answer before the portal went out is ignored"), Attempts.ConsumeAnswer());
+	Attempts.MarkSent();
+	TestTrue(TEXT("Portal answer counts"), Attempts.ConsumeAnswer());
+
+	// A second cached log in started while the first one is still out
+	Attempts.End();
+	Attempts.Begin(true);
+	Attempts.MarkSent();
+	Attempts.End();
+	Attempts.Begin(true);
+	Attempts.MarkSent();
+	TestFalse(TEXT("The older cached answer is ignored"), Attempts.ConsumeAnswer());
+	TestTrue(TEXT("The newer one counts"), Attempts.ConsumeAnswer());
+	TestFalse(TEXT("Nothing left in flight"), Attempts.HasPersistentInFlight());
+	return true;
+}
+
+#endif
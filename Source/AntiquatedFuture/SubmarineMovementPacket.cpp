@@ -0,0 +1,21 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SubmarineMovementPacket.h"
+#include "Engine/NetSerialization.h"
+
+bool FSubmarineMovementPacket::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+	Ar << Sequence;
+	Ar << State.Timestamp;
+	// Each of these overwrites its flag, so collect them one at a time
+	bool bFieldSuccess = true;
+	State.Position.NetSerialize(Ar, Map, bFieldSuccess);
+	bOutSuccess &= bFieldSuccess;
+	State.Orientation.NetSerialize(Ar, Map, bFieldSuccess);
+	bOutSuccess &= bFieldSuccess;
+	State.Velocity.NetSerialize(Ar, Map, bFieldSuccess);
+	bOutSuccess &= bFieldSuccess;
+	return true;
+}
@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RepFloatingMovement.h"
+#include "SubmarineMovementPacket.generated.h"
+
+/**
+ * What a locally controlled Pawn sends the Server every frame. Only the newest state the Server has is ever applied,
+ * so a dropped unreliable packet is simply replaced by the next one a frame later.
+ */
+USTRUCT()
+struct FSubmarineMovementPacket
+{
+	GENERATED_BODY()
+
+	FRepFloatingMovement State;
+	// Counts up once per packet. Orders packets without trusting the Client's clock.
+	uint16 Sequence = 0;
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FSubmarineMovementPacket> : public TStructOpsTypeTraitsBase2<FSubmarineMovementPacket>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
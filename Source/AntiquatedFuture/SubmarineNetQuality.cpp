@@ -0,0 +1,296 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SubmarineNetQuality.h"
+#include "AntiquatedFuture.h"
+#include "SubmarinePawn.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+	constexpr int32 NumMetrics = static_cast<int32>(ESubmarineNetQualityMetric::Num);
+
+	TAutoConsoleVariable<bool> CVarNetQualityEnabled(
+		TEXT("Submarine.NetQuality.Enabled"),
+		false,
+		TEXT("Measure snap distance, update inter-arrival, stale time and future timestamps for every proxy"));
+
+	FAutoConsoleCommandWithWorld NetQualityDumpCommand(
+		TEXT("Submarine.NetQuality"),
+		TEXT("Logs snap distance, update inter-arrival, stale time and future timestamp percentiles for this match"),
+		FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+		{
+			if (const auto NetQuality = World ? World->GetSubsystem<USubmarineNetQualitySubsystem>() : nullptr)
+			{
+				NetQuality->Dump();
+			}
+		}));
+
+	FAutoConsoleCommandWithWorld NetQualityResetCommand(
+		TEXT("Submarine.NetQuality.Reset"),
+		TEXT("Clears the histograms logged by Submarine.NetQuality"),
+		FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+		{
+			if (const auto NetQuality = World ? World->GetSubsystem<USubmarineNetQualitySubsystem>() : nullptr)
+			{
+				NetQuality->Reset();
+			}
+		}));
+}
+
+void FSubmarineNetHistogram::Add(const float Value)
+{
+	const float Scaled = FMath::Max(Value, 0.f) / FirstBucketSize;
+	const int32 Bucket = Scaled < 1.f ? 0 : FMath::Min(
+		static_cast<int32>(FMath::FloorLog2(static_cast<uint32>(FMath::Min(Scaled, float(MAX_uint32))))) + 1,
+		NumBuckets - 1);
+	++Counts[Bucket];
+	++NumSamples;
+	Sum += Value;
+	Max = FMath::Max(Max, Value);
+}
+
+void FSubmarineNetHistogram::Merge(const FSubmarineNetHistogram& Other)
+{
+	for (int32 i = 0; i < NumBuckets; ++i)
+	{
+		Counts[i] += Other.Counts[i];
+	}
+	NumSamples += Other.NumSamples;
+	Sum += Other.Sum;
+	Max = FMath::Max(Max, Other.Max);
+}
+
+float FSubmarineNetHistogram::GetBucketUpperBound(const int32 Bucket) const
+{
+	// The last bucket has no upper bound, the worst we've seen will have to do
+	return Bucket < NumBuckets - 1 ? FirstBucketSize * static_cast<float>(1 << Bucket) : Max;
+}
+
+float FSubmarineNetHistogram::GetPercentile(const float Fraction) const
+{
+	if (NumSamples == 0)
+	{
+		return 0.f;
+	}
+	const uint32 Target = FMath::Max(1u, static_cast<uint32>(FMath::CeilToInt(Fraction * NumSamples)));
+	uint32 Seen = 0;
+	for (int32 i = 0; i < NumBuckets; ++i)
+	{
+		Seen += Counts[i];
+		if (Seen >= Target)
+		{
+			return FMath::Min(GetBucketUpperBound(i), Max);
+		}
+	}
+	return Max;
+}
+
+bool USubmarineNetQualitySubsystem::IsEnabled()
+{
+	static const bool bIsEnabledOnCommandLine = FParse::Param(FCommandLine::Get(), TEXT("SubmarineNetQuality"));
+	return bIsEnabledOnCommandLine || CVarNetQualityEnabled.GetValueOnGameThread();
+}
+
+bool USubmarineNetQualitySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void USubmarineNetQualitySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	MatchStartTime = FPlatformTime::Seconds();
+}
+
+void USubmarineNetQualitySubsystem::Deinitialize()
+{
+	// The world going away is the end of the match
+	ExportCsv();
+	Super::Deinitialize();
+}
+
+const TCHAR* USubmarineNetQualitySubsystem::GetMetricName(const ESubmarineNetQualityMetric Metric)
+{
+	switch (Metric)
+	{
+		case ESubmarineNetQualityMetric::SnapDistance:
+			return TEXT("SnapCm");
+		case ESubmarineNetQualityMetric::InterArrival:
+			return TEXT("InterArrivalMs");
+		case ESubmarineNetQualityMetric::Stale:
+			return TEXT("StaleMs");
+		case ESubmarineNetQualityMetric::FutureTimestamp:
+			return TEXT("FutureTimestampMs");
+		default:
+			return TEXT("Unknown");
+	}
+}
+
+FSubmarineNetHistogram USubmarineNetQualitySubsystem::MakeHistogram(const ESubmarineNetQualityMetric Metric)
+{
+	FSubmarineNetHistogram Histogram;
+	switch (Metric)
+	{
+		case ESubmarineNetQualityMetric::InterArrival:
+			Histogram.FirstBucketSize = 4.f;
+			break;
+		case ESubmarineNetQualityMetric::Stale:
+			Histogram.FirstBucketSize = 8.f;
+			break;
+		default:
+			Histogram.FirstBucketSize = 1.f;
+			break;
+	}
+	return Histogram;
+}
+
+USubmarineNetQualitySubsystem::FProxyQuality& USubmarineNetQualitySubsystem::FindOrAddProxy(const ASubmarinePawn* Pawn)
+{
+	const TObjectKey<ASubmarinePawn> Key(Pawn);
+	if (FProxyQuality* Existing = Proxies.Find(Key))
+	{
+		return *Existing;
+	}
+	LLM_SCOPE_BYTAG(Submarine_Pawn);
+	FProxyQuality& Proxy = Proxies.Add(Key);
+	Proxy.Name = Pawn->GetName();
+	for (int32 i = 0; i < NumMetrics; ++i)
+	{
+		Proxy.Histograms[i] = MakeHistogram(static_cast<ESubmarineNetQualityMetric>(i));
+	}
+	return Proxy;
+}
+
+void USubmarineNetQualitySubsystem::Record(
+	const ASubmarinePawn* Pawn, const ESubmarineNetQualityMetric Metric, const float Value)
+{
+	if (Pawn)
+	{
+		FindOrAddProxy(Pawn).Histograms[static_cast<int32>(Metric)].Add(Value);
+	}
+}
+
+void USubmarineNetQualitySubsystem::RecordArrival(const ASubmarinePawn* Pawn)
+{
+	if (Pawn == nullptr)
+	{
+		return;
+	}
+	FProxyQuality& Proxy = FindOrAddProxy(Pawn);
+	const double CurrentTime = FPlatformTime::Seconds();
+	if (Proxy.LastArrivalTime >= 0.0)
+	{
+		Proxy.Histograms[static_cast<int32>(ESubmarineNetQualityMetric::InterArrival)].Add(
+			static_cast<float>((CurrentTime - Proxy.LastArrivalTime) * 1000.0));
+	}
+	Proxy.LastArrivalTime = CurrentTime;
+}
+
+FSubmarineNetHistogram USubmarineNetQualitySubsystem::GetMatchHistogram(const ESubmarineNetQualityMetric Metric) const
+{
+	FSubmarineNetHistogram Histogram = MakeHistogram(Metric);
+	for (const auto& Pair: Proxies)
+	{
+		Histogram.Merge(Pair.Value.Histograms[static_cast<int32>(Metric)]);
+	}
+	return Histogram;
+}
+
+void USubmarineNetQualitySubsystem::Dump() const
+{
+	if (!IsEnabled() && Proxies.Num() == 0)
+	{
+		UE_LOG(LogSubmarineNet, Warning,
+			TEXT("Net quality isn't being measured. Set Submarine.NetQuality.Enabled 1 first."))
+		return;
+	}
+	const auto LogHistograms = [](const FString& Label, const FSubmarineNetHistogram* Histograms)
+	{
+		UE_LOG(LogSubmarineNet, Log, TEXT("%s"), *Label)
+		for (int32 i = 0; i < NumMetrics; ++i)
+		{
+			const FSubmarineNetHistogram& Histogram = Histograms[i];
+			if (Histogram.NumSamples == 0)
+			{
+				continue;
+			}
+			UE_LOG(LogSubmarineNet, Log, TEXT("  %-18s n: %6u  mean: %8.1f  p50: %8.1f  p95: %8.1f  p99: %8.1f  max: %8.1f"),
+				GetMetricName(static_cast<ESubmarineNetQualityMetric>(i)), Histogram.NumSamples, Histogram.GetMean(),
+				Histogram.GetPercentile(0.5f), Histogram.GetPercentile(0.95f), Histogram.GetPercentile(0.99f),
+				Histogram.Max)
+		}
+	};
+
+	FSubmarineNetHistogram MatchHistograms[NumMetrics];
+	for (int32 i = 0; i < NumMetrics; ++i)
+	{
+		MatchHistograms[i] = GetMatchHistogram(static_cast<ESubmarineNetQualityMetric>(i));
+	}
+	LogHistograms(FString::Printf(TEXT("Net quality over %.1f s, %d proxies:"),
+		FPlatformTime::Seconds() - MatchStartTime, Proxies.Num()), MatchHistograms);
+	for (const auto& Pair: Proxies)
+	{
+		LogHistograms(Pair.Value.Name, Pair.Value.Histograms);
+	}
+}
+
+void USubmarineNetQualitySubsystem::ExportCsv() const
+{
+	if (Proxies.Num() == 0)
+	{
+		return;
+	}
+	const FString CsvPath = FPaths::ProfilingDir() / TEXT("NetQuality.csv");
+	if (!IFileManager::Get().FileExists(*CsvPath))
+	{
+		FString Header = TEXT("Timestamp,Map,NetMode,Proxy,Metric,Samples,Mean,P50,P95,P99,Max,FirstBucket");
+		for (int32 i = 0; i < FSubmarineNetHistogram::NumBuckets; ++i)
+		{
+			Header += FString::Printf(TEXT(",B%d"), i);
+		}
+		FFileHelper::SaveStringToFile(Header + LINE_TERMINATOR, *CsvPath);
+	}
+
+	const FString Prefix = FString::Printf(TEXT("%s,%s,%d"), *FDateTime::Now().ToString(),
+		*GetWorld()->GetMapName(), static_cast<int32>(GetWorld()->GetNetMode()));
+	FString Rows;
+	const auto AddRow = [&Rows, &Prefix](const FString& Proxy, const int32 Metric, const FSubmarineNetHistogram& Histogram)
+	{
+		if (Histogram.NumSamples == 0)
+		{
+			return;
+		}
+		Rows += FString::Printf(TEXT("%s,%s,%s,%u,%.2f,%.2f,%.2f,%.2f,%.2f,%.0f"), *Prefix, *Proxy,
+			GetMetricName(static_cast<ESubmarineNetQualityMetric>(Metric)), Histogram.NumSamples, Histogram.GetMean(),
+			Histogram.GetPercentile(0.5f), Histogram.GetPercentile(0.95f), Histogram.GetPercentile(0.99f),
+			Histogram.Max, Histogram.FirstBucketSize);
+		for (const uint32 Count: Histogram.Counts)
+		{
+			Rows += FString::Printf(TEXT(",%u"), Count);
+		}
+		Rows += LINE_TERMINATOR;
+	};
+	for (int32 i = 0; i < NumMetrics; ++i)
+	{
+		AddRow(TEXT("All"), i, GetMatchHistogram(static_cast<ESubmarineNetQualityMetric>(i)));
+	}
+	for (const auto& Pair: Proxies)
+	{
+		for (int32 i = 0; i < NumMetrics; ++i)
+		{
+			AddRow(Pair.Value.Name, i, Pair.Value.Histograms[i]);
+		}
+	}
+	FFileHelper::SaveStringToFile(Rows, *CsvPath, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(),
+		FILEWRITE_Append);
+	UE_LOG(LogSubmarineNet, Log, TEXT("Net quality for %d proxies written to %s"), Proxies.Num(), *CsvPath)
+}
+
+void USubmarineNetQualitySubsystem::Reset()
+{
+	Proxies.Reset();
+	MatchStartTime = FPlatformTime::Seconds();
+}
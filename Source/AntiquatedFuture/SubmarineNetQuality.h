@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "SubmarineNetQuality.generated.h"
+
+class ASubmarinePawn;
+
+enum class ESubmarineNetQualityMetric : uint8
+{
+	// How far a fresh state moved a proxy away from where we had extrapolated it to (cm)
+	SnapDistance,
+	// Time between two movement updates arriving for the same proxy (ms)
+	InterArrival,
+	// How long a proxy sat frozen past ExtrapolationLimit (or the idle update interval, if it was parked) before the
+	// next update showed up (ms)
+	Stale,
+	// How far ahead of our clock a movement or shot timestamp was before it got clamped to now (ms)
+	FutureTimestamp,
+	Num
+};
+
+/**
+ * Counts in buckets that double in width: [0, FirstBucketSize), [FirstBucketSize, 2 * FirstBucketSize), ... with
+ * everything past the last bound landing in the final bucket.
+ */
+struct ANTIQUATEDFUTURE_API FSubmarineNetHistogram
+{
+	static constexpr int32 NumBuckets = 12;
+
+	float FirstBucketSize = 1.f;
+	uint32 Counts[NumBuckets] = {};
+	uint32 NumSamples = 0;
+	double Sum = 0.0;
+	float Max = 0.f;
+
+	void Add(const float Value);
+	void Merge(const FSubmarineNetHistogram& Other);
+	float GetBucketUpperBound(const int32 Bucket) const;
+	// Upper bound of the bucket the percentile falls in, so it's as precise as the buckets are
+	float GetPercentile(const float Fraction) const;
+	float GetMean() const { return NumSamples ? static_cast<float>(Sum / NumSamples) : 0.f; }
+};
+
+/**
+ * How good remote submarines look on this machine, for one match. Movement code reports each proxy's corrections,
+ * update arrivals, stale periods and clamped timestamps; Clients see the Server's view of everyone else, the Server
+ * sees each Client's. Only measured while Submarine.NetQuality.Enabled is set or the game was started with
+ * -SubmarineNetQuality.
+ *
+ * Submarine.NetQuality logs per-proxy and match-wide percentiles, Submarine.NetQuality.Reset starts over. A match
+ * that measured anything also appends its histograms to Saved/Profiling/NetQuality.csv when the world goes away.
+ */
+UCLASS()
+class ANTIQUATEDFUTURE_API USubmarineNetQualitySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+	struct FProxyQuality
+	{
+		FString Name;
+		FSubmarineNetHistogram Histograms[static_cast<int32>(ESubmarineNetQualityMetric::Num)];
+		double LastArrivalTime = -1.0;
+	};
+
+	// Keyed by object so Pawns that were destroyed mid-match still count
+	TMap<TObjectKey<ASubmarinePawn>, FProxyQuality> Proxies;
+	double MatchStartTime = 0.0;
+
+	FProxyQuality& FindOrAddProxy(const ASubmarinePawn* Pawn);
+	FSubmarineNetHistogram GetMatchHistogram(const ESubmarineNetQualityMetric Metric) const;
+	static FSubmarineNetHistogram MakeHistogram(const ESubmarineNetQualityMetric Metric);
+
+public:
+	// Callers check this before measuring anything
+	static bool IsEnabled();
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	void Record(const ASubmarinePawn* Pawn, const ESubmarineNetQualityMetric Metric, const float Value);
+	// Records the time since this proxy's last update
+	void RecordArrival(const ASubmarinePawn* Pawn);
+
+	static const TCHAR* GetMetricName(const ESubmarineNetQualityMetric Metric);
+	void Dump() const;
+	void ExportCsv() const;
+	void Reset();
+};
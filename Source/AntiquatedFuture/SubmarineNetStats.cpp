@@ -0,0 +1,186 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SubmarineNetStats.h"
+#include "AntiquatedFuture.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "GameFramework/Actor.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+DECLARE_STATS_GROUP(TEXT("SubmarineNet"), STATGROUP_SubmarineNet, STATCAT_Advanced);
+DECLARE_DWORD_COUNTER_STAT(TEXT("MovementRpc bits"), STAT_SubmarineNet_MovementRpc, STATGROUP_SubmarineNet);
+DECLARE_DWORD_COUNTER_STAT(TEXT("StartShootingRpc bits"), STAT_SubmarineNet_StartShootingRpc, STATGROUP_SubmarineNet);
+DECLARE_DWORD_COUNTER_STAT(TEXT("StopShootingRpc bits"), STAT_SubmarineNet_StopShootingRpc, STATGROUP_SubmarineNet);
+DECLARE_DWORD_COUNTER_STAT(TEXT("ServerMovement bits"), STAT_SubmarineNet_ServerMovement, STATGROUP_SubmarineNet);
+DECLARE_DWORD_COUNTER_STAT(TEXT("FiringState bits"), STAT_SubmarineNet_FiringState, STATGROUP_SubmarineNet);
+DECLARE_DWORD_COUNTER_STAT(TEXT("HitEvent bits"), STAT_SubmarineNet_HitEvent, STATGROUP_SubmarineNet);
+
+CSV_DEFINE_CATEGORY(SubmarineNet, true);
+
+namespace
+{
+	constexpr int32 NumStats = static_cast<int32>(ESubmarineNetStat::Num);
+
+	TAutoConsoleVariable<bool> CVarNetStatsEnabled(
+		TEXT("Submarine.NetStats.Enabled"),
+		false,
+		TEXT("Measure how many bits each of our RPCs and replicated properties costs, per connection"));
+
+	struct FNetStatCounters
+	{
+		// [Stat][0 = in, 1 = out]
+		int64 Bits[NumStats][2] = {};
+		int64 Count[NumStats][2] = {};
+	};
+
+	FNetStatCounters TotalCounters;
+	TMap<FString, FNetStatCounters> ConnectionCounters;
+	double CountersStartTime = FPlatformTime::Seconds();
+
+	void LogCounters(const FString& Label, const FNetStatCounters& Counters, const double Seconds)
+	{
+		UE_LOG(LogSubmarineNet, Log, TEXT("%s"), *Label)
+		for (int32 i = 0; i < NumStats; ++i)
+		{
+			if (Counters.Count[i][0] == 0 && Counters.Count[i][1] == 0)
+			{
+				continue;
+			}
+			UE_LOG(LogSubmarineNet, Log, TEXT("  %-18s in: %6lld x %5.1f bits = %8.1f B/s   out: %6lld x %5.1f bits = %8.1f B/s"),
+				FSubmarineNetStats::GetStatName(static_cast<ESubmarineNetStat>(i)),
+				Counters.Count[i][0], Counters.Count[i][0] ? double(Counters.Bits[i][0]) / Counters.Count[i][0] : 0.0,
+				Counters.Bits[i][0] / 8.0 / Seconds,
+				Counters.Count[i][1], Counters.Count[i][1] ? double(Counters.Bits[i][1]) / Counters.Count[i][1] : 0.0,
+				Counters.Bits[i][1] / 8.0 / Seconds)
+		}
+	}
+
+	FAutoConsoleCommand NetStatsDumpCommand(
+		TEXT("Submarine.NetStats"),
+		TEXT("Logs the bits and bytes/second spent on each of our RPCs and replicated properties, per connection"),
+		FConsoleCommandDelegate::CreateStatic(&FSubmarineNetStats::Dump));
+
+	FAutoConsoleCommand NetStatsResetCommand(
+		TEXT("Submarine.NetStats.Reset"),
+		TEXT("Clears the counters logged by Submarine.NetStats"),
+		FConsoleCommandDelegate::CreateStatic(&FSubmarineNetStats::Reset));
+}
+
+bool FSubmarineNetStats::IsEnabled()
+{
+	static const bool bIsEnabledOnCommandLine = FParse::Param(FCommandLine::Get(), TEXT("SubmarineNetStats"));
+	return bIsEnabledOnCommandLine || CVarNetStatsEnabled.GetValueOnGameThread();
+}
+
+const TCHAR* FSubmarineNetStats::GetStatName(const ESubmarineNetStat Stat)
+{
+	switch (Stat)
+	{
+		case ESubmarineNetStat::MovementRpc:
+			return TEXT("MovementRpc");
+		case ESubmarineNetStat::StartShootingRpc:
+			return TEXT("StartShootingRpc");
+		case ESubmarineNetStat::StopShootingRpc:
+			return TEXT("StopShootingRpc");
+		case ESubmarineNetStat::ServerMovement:
+			return TEXT("ServerMovement");
+		case ESubmarineNetStat::FiringState:
+			return TEXT("FiringState");
+		case ESubmarineNetStat::HitEvent:
+			return TEXT("HitEvent");
+		default:
+			return TEXT("Unknown");
+	}
+}
+
+void FSubmarineNetStats::Record(const ESubmarineNetStat Stat, const bool bIsOutgoing, const int64 NumBits,
+	UNetConnection* Connection)
+{
+	const int32 StatIndex = static_cast<int32>(Stat);
+	const int32 Direction = bIsOutgoing ? 1 : 0;
+	TotalCounters.Bits[StatIndex][Direction] += NumBits;
+	++TotalCounters.Count[StatIndex][Direction];
+	FNetStatCounters& Counters = ConnectionCounters.FindOrAdd(
+		Connection ? Connection->LowLevelGetRemoteAddress(true) : TEXT("Local"));
+	Counters.Bits[StatIndex][Direction] += NumBits;
+	++Counters.Count[StatIndex][Direction];
+
+	switch (Stat)
+	{
+		case ESubmarineNetStat::MovementRpc:
+			INC_DWORD_STAT_BY(STAT_SubmarineNet_MovementRpc, NumBits);
+			break;
+		case ESubmarineNetStat::StartShootingRpc:
+			INC_DWORD_STAT_BY(STAT_SubmarineNet_StartShootingRpc, NumBits);
+			break;
+		case ESubmarineNetStat::StopShootingRpc:
+			INC_DWORD_STAT_BY(STAT_SubmarineNet_StopShootingRpc, NumBits);
+			break;
+		case ESubmarineNetStat::ServerMovement:
+			INC_DWORD_STAT_BY(STAT_SubmarineNet_ServerMovement, NumBits);
+			break;
+		case ESubmarineNetStat::FiringState:
+			INC_DWORD_STAT_BY(STAT_SubmarineNet_FiringState, NumBits);
+			break;
+		case ESubmarineNetStat::HitEvent:
+			INC_DWORD_STAT_BY(STAT_SubmarineNet_HitEvent, NumBits);
+			break;
+		default:
+			break;
+	}
+
+#if CSV_PROFILER
+	static const FName CsvStatNames[NumStats][2] = {
+		{"MovementRpcIn", "MovementRpcOut"},
+		{"StartShootingRpcIn", "StartShootingRpcOut"},
+		{"StopShootingRpcIn", "StopShootingRpcOut"},
+		{"ServerMovementIn", "ServerMovementOut"},
+		{"FiringStateIn", "FiringStateOut"},
+		{"HitEventIn", "HitEventOut"},
+	};
+	FCsvProfiler::RecordCustomStat(CsvStatNames[StatIndex][Direction], CSV_CATEGORY_INDEX(SubmarineNet),
+		static_cast<int32>(NumBits), ECsvCustomStatOp::Accumulate);
+#endif
+}
+
+void FSubmarineNetStats::RecordToRelevantConnections(const ESubmarineNetStat Stat, const int64 NumBits, AActor* Actor,
+	const bool bSkipOwner)
+{
+	const UNetDriver* NetDriver = Actor ? Actor->GetNetDriver() : nullptr;
+	if (NetDriver == nullptr)
+	{
+		return;
+	}
+	const UNetConnection* OwnerConnection = bSkipOwner ? Actor->GetNetConnection() : nullptr;
+	for (UNetConnection* Connection : NetDriver->ClientConnections)
+	{
+		if (Connection && Connection != OwnerConnection && Connection->FindActorChannelRef(Actor))
+		{
+			Record(Stat, true, NumBits, Connection);
+		}
+	}
+}
+
+void FSubmarineNetStats::Dump()
+{
+	if (!IsEnabled())
+	{
+		UE_LOG(LogSubmarineNet, Warning, TEXT("Net stats aren't being measured. Set Submarine.NetStats.Enabled 1 first."))
+		return;
+	}
+	const double Seconds = FMath::Max(FPlatformTime::Seconds() - CountersStartTime, 0.001);
+	LogCounters(FString::Printf(TEXT("Submarine net stats over %.1f s, all connections:"), Seconds), TotalCounters,
+		Seconds);
+	for (const auto& Pair: ConnectionCounters)
+	{
+		LogCounters(FString::Printf(TEXT("%s:"), *Pair.Key), Pair.Value, Seconds);
+	}
+}
+
+void FSubmarineNetStats::Reset()
+{
+	TotalCounters = FNetStatCounters();
+	ConnectionCounters.Reset();
+	CountersStartTime = FPlatformTime::Seconds();
+}
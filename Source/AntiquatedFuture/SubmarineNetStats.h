@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Serialization/BitWriter.h"
+
+class AActor;
+class UNetConnection;
+
+enum class ESubmarineNetStat : uint8
+{
+	MovementRpc,
+	StartShootingRpc,
+	StopShootingRpc,
+	ServerMovement,
+	FiringState,
+	// Projectiles don't replicate, their hits reach Clients through ASubmarineHitStream
+	HitEvent,
+	Num
+};
+
+/**
+ * Which of our RPCs and replicated properties the bandwidth goes to, per connection. Sizes are the payload bits our
+ * own serialization produces (no packet or bunch headers), and are only measured while Submarine.NetStats.Enabled is
+ * set or the game was started with -SubmarineNetStats.
+ *
+ * Submarine.NetStats dumps totals and rates, Submarine.NetStats.Reset starts over, `stat SubmarineNet` shows bits per
+ * frame, and each stat is also a CSV custom stat so -csvprofile picks them up on a headless server.
+ */
+class ANTIQUATEDFUTURE_API FSubmarineNetStats
+{
+public:
+	static bool IsEnabled();
+	static void Record(const ESubmarineNetStat Stat, const bool bIsOutgoing, const int64 NumBits,
+		UNetConnection* Connection);
+	// Outgoing to every Client that has a channel open for the Actor, i.e. everyone the change will be sent to
+	static void RecordToRelevantConnections(const ESubmarineNetStat Stat, const int64 NumBits, AActor* Actor,
+		const bool bSkipOwner);
+
+	template<typename FuncType>
+	static int64 MeasureBits(FuncType&& Serialize)
+	{
+		FBitWriter Writer(0, true);
+		Serialize(Writer);
+		return Writer.GetNumBits();
+	}
+
+	static const TCHAR* GetStatName(const ESubmarineNetStat Stat);
+	static void Dump();
+	static void Reset();
+};
@@ -1,6 +1,13 @@
 #include "SubmarinePawn.h"
+#include "AntiquatedFuture.h"
+#include "SubmarineGameInstance.h"
+#include "SubmarineNetQuality.h"
+#include "SubmarineNetStats.h"
 #include "SubmarinePlayerController.h"
+#include "SubmarineProxyMovementSubsystem.h"
+#include "SubmarineSignificanceSubsystem.h"
 #include "Camera/CameraComponent.h"
+#include "Engine/NetDriver.h"
 #include "Components/SphereComponent.h"
 #include "EnhancedInputComponent.h"
 #include "EnhancedInputSubsystems.h"
@@ -11,8 +18,65 @@
 #include "Kismet/GameplayStatics.h"
 #include "Net/UnrealNetwork.h"
 
+namespace
+{
+	int64 MeasureMovementBits(FRepFloatingMovement Movement)
+	{
+		return FSubmarineNetStats::MeasureBits([&Movement](FArchive& Ar)
+		{
+			bool bOutSuccess;
+			Ar << Movement.Timestamp;
+			Movement.Position.NetSerialize(Ar, nullptr, bOutSuccess);
+			Movement.Orientation.NetSerialize(Ar, nullptr, bOutSuccess);
+			Movement.Velocity.NetSerialize(Ar, nullptr, bOutSuccess);
+		});
+	}
+
+	int64 MeasureMovementPacketBits(FSubmarineMovementPacket Packet)
+	{
+		return FSubmarineNetStats::MeasureBits([&Packet](FArchive& Ar)
+		{
+			bool bOutSuccess;
+			Packet.NetSerialize(Ar, nullptr, bOutSuccess);
+		});
+	}
+
+	int64 MeasureFiringStateBits(FSubmarineFiringState FiringState)
+	{
+		return FSubmarineNetStats::MeasureBits([&FiringState](FArchive& Ar)
+		{
+			Ar << FiringState.FiringWeapons;
+			Ar << FiringState.PhaseTimestamp;
+		});
+	}
+
+	int64 MeasureStartShootingBits(uint8 WeaponIndex, float TimeStamp, FVector_NetQuantize Position, FQuat Rotation,
+		FVector_NetQuantize10 Velocity)
+	{
+		return FSubmarineNetStats::MeasureBits([&](FArchive& Ar)
+		{
+			bool bOutSuccess;
+			Ar << WeaponIndex;
+			Ar << TimeStamp;
+			Position.NetSerialize(Ar, nullptr, bOutSuccess);
+			Rotation.NetSerialize(Ar, nullptr, bOutSuccess);
+			Velocity.NetSerialize(Ar, nullptr, bOutSuccess);
+		});
+	}
+
+	// Both arguments are fixed size
+	constexpr int64 StopShootingBits = 8 + 32;
+
+	UNetConnection* GetServerConnection(const AActor* Actor)
+	{
+		const UNetDriver* NetDriver = Actor->GetNetDriver();
+		return NetDriver ? NetDriver->ServerConnection : nullptr;
+	}
+}
+
 ASubmarinePawn::ASubmarinePawn()
 {
+	LLM_SCOPE_BYTAG(Submarine_Pawn);
 	Sphere = CreateDefaultSubobject<USphereComponent>(TEXT("Sphere"));
 	SetRootComponent(Sphere);
 
@@ -38,9 +102,17 @@ ASubmarinePawn::ASubmarinePawn()
 	ServerMovement = FRepFloatingMovement();
 
 	bWeaponsAreInitialized = false;
+	bHasSentMovement = false;
+	ProxyMovementIndex = INDEX_NONE;
 	//bHasReceivedMovement = false;
 }
 
+FString ASubmarinePawn::GetNetDebugName() const
+{
+	return FString::Printf(TEXT("[%s | %s | %s]"), *GetName(), *UEnum::GetValueAsString(GetLocalRole()),
+		*ToString(GetNetMode()));
+}
+
 FString ASubmarinePawn::ToString(ENetMode NetMode) const
 {
 	switch (NetMode)
@@ -65,13 +137,37 @@ void ASubmarinePawn::GetLifetimeReplicatedProps(TArray< FLifetimeProperty > & Ou
 
 	//DOREPLIFETIME(ASubmarinePawn, bHasReceivedMovement);
 	DOREPLIFETIME_CONDITION(ASubmarinePawn, ServerMovement, COND_SkipOwner);
+	DOREPLIFETIME_CONDITION(ASubmarinePawn, FiringState, COND_SkipOwner);
 	// We'll manually invoke the local state changes - we trust our clients (: )
 	DOREPLIFETIME(ASubmarinePawn, bIsJuggernaut);
 }
 
+void ASubmarinePawn::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+	if (!FSubmarineNetStats::IsEnabled())
+	{
+		return;
+	}
+	if (ServerMovement.Timestamp != LastMeasuredMovementTimestamp)
+	{
+		LastMeasuredMovementTimestamp = ServerMovement.Timestamp;
+		FSubmarineNetStats::RecordToRelevantConnections(ESubmarineNetStat::ServerMovement,
+			MeasureMovementBits(ServerMovement), this, true);
+	}
+	if (FiringState.FiringWeapons != LastMeasuredFiringWeapons || FiringState.PhaseTimestamp != LastMeasuredFirePhase)
+	{
+		LastMeasuredFiringWeapons = FiringState.FiringWeapons;
+		LastMeasuredFirePhase = FiringState.PhaseTimestamp;
+		FSubmarineNetStats::RecordToRelevantConnections(ESubmarineNetStat::FiringState,
+			MeasureFiringStateBits(FiringState), this, true);
+	}
+}
+
 // Called when the game starts
 void ASubmarinePawn::BeginPlay()
 {
+	LLM_SCOPE_BYTAG(Submarine_Pawn);
 	Super::BeginPlay();
 
 	Weapons = TArray<USubmarineWeapon*>();
@@ -82,26 +178,87 @@ void ASubmarinePawn::BeginPlay()
 	GameState = GetWorld()->GetGameState();
 	
 	const auto LocalRole = GetLocalRole();
-	const auto LocalRoleString = UEnum::GetValueAsString(GetLocalRole());
-	const auto RemoteRoleString = UEnum::GetValueAsString(GetRemoteRole());
 	const auto NetMode = GetWorld()->GetNetMode();
-	const auto NetModeString = ToString(NetMode);
 
 	ServerMovement = FRepFloatingMovement();
 	ServerMovement.Timestamp = -ExtrapolationLimit;
 	
-	NetDebugName = FString::Printf(TEXT("[%s | %s | %s]"),
-		*GetName(), *LocalRoleString, *NetModeString);
-	
-	UE_LOG(LogTemp, Warning, TEXT("Spawned: %s || Is Authority: %s || Is Locally Controlled: %s"),
-		*NetDebugName,
+	UE_LOG(LogSubmarineNet, Log, TEXT("Spawned: %s || Is Authority: %s || Is Locally Controlled: %s"),
+		*GetNetDebugName(),
 		IsAuthority() ? *FString("Yes") : *FString("No"),
 		IsLocallyControlled() ? *FString("Yes") : *FString("No"));
 
 	CurrentDashCooldown = DashCooldown;
 	TimeLastDashFinished = UGameplayStatics::GetTimeSeconds(GetWorld());
 	LastTimestampApplied = -1.f;
-	
+	NextMovementSequence = 0;
+	bHasReceivedMovementSequence = false;
+	LastMovementSequenceReceived = 0;
+	bIsNetIdle = false;
+	ActiveNetUpdateFrequency = NetUpdateFrequency;
+	TimeLastNetActive = GetWorld()->GetTimeSeconds();
+	LastActiveOrientation = ServerMovement.Orientation;
+	LastMeasuredMovementTimestamp = ServerMovement.Timestamp;
+	LastMeasuredFiringWeapons = 0;
+	LastMeasuredFirePhase = 0.f;
+
+	// Other players' submarines can be throttled when we can barely see them
+	if (LocalRole == ROLE_SimulatedProxy && NetMode == NM_Client)
+	{
+		if (const auto Significance = GetWorld()->GetSubsystem<USubmarineSignificanceSubsystem>())
+		{
+			Significance->Register(this);
+		}
+	}
+
+	// Remotely controlled movement is extrapolated in one batch for all Pawns, so only local Pawns need to Tick
+	if (NetMode != NM_Standalone)
+	{
+		if (const auto ProxyMovement = GetWorld()->GetSubsystem<USubmarineProxyMovementSubsystem>())
+		{
+			ProxyMovement->Register(this);
+		}
+	}
+	if (LocalRole == ROLE_SimulatedProxy)
+	{
+		SetActorTickEnabled(false);
+	}
+	// Whatever was already firing in the initial bunch was held back until the Weapons existed
+	if (FiringState.FiringWeapons != 0)
+	{
+		ApplyFiringState(FSubmarineFiringState());
+	}
+}
+
+void ASubmarinePawn::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (const auto Significance = GetWorld()->GetSubsystem<USubmarineSignificanceSubsystem>())
+	{
+		Significance->Unregister(this);
+	}
+	if (const auto ProxyMovement = GetWorld()->GetSubsystem<USubmarineProxyMovementSubsystem>())
+	{
+		ProxyMovement->Unregister(this);
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+void ASubmarinePawn::NotifyControllerChanged()
+{
+	Super::NotifyControllerChanged();
+	// Possession on the Server (or Controller replication on the owning Client) decides whether we need to Tick
+	SetActorTickEnabled(IsLocallyControlled());
+	// A new owner numbers its packets from 0, which mustn't look older than the last owner's
+	NextMovementSequence = 0;
+	bHasReceivedMovementSequence = false;
+	LastMovementSequenceReceived = 0;
+	if (IsLocallyControlled())
+	{
+		if (const auto SubmarineGameInstance = GetGameInstance<USubmarineGameInstance>())
+		{
+			SubmarineGameInstance->MarkJoinPhase(ESubmarineJoinPhase::Possessed);
+		}
+	}
 }
 
 bool ASubmarinePawn::IsLocalControl() const
@@ -125,15 +282,26 @@ void ASubmarinePawn::CalculateAndSendUpdates(float DeltaTime)
 		const float NewRoll = FMath::Lerp(CurrentRot.Roll, TargetRoll, DeltaTime * CorrectiveSpeed);
 		SetActorRotation(FRotator(CurrentRot.Pitch, CurrentRot.Yaw, NewRoll));
 	}
-	//UE_LOG(LogTemp, Log, TEXT("%s sending Movement updates"), *NetDebugName);
-	// TODO: Send delta frames when we haven't moved too much since last update
+	//UE_LOG(LogTemp, Log, TEXT("%s sending Movement updates"), *GetNetDebugName());
 	const auto Transform = RootComponent->GetComponentTransform();
-	ServerSetTransform(
-		GameState->GetServerWorldTimeSeconds(),
-		Transform.GetLocation(),
-		Transform.GetRotation(),
-		GetVelocity()
-		);
+	FSubmarineMovementPacket Packet;
+	Packet.State = FRepFloatingMovement(GameState->GetServerWorldTimeSeconds(), Transform.GetLocation(),
+		Transform.GetRotation(), GetVelocity());
+	Packet.Sequence = NextMovementSequence++;
+	if (FSubmarineNetStats::IsEnabled() && !IsAuthority())
+	{
+		FSubmarineNetStats::Record(ESubmarineNetStat::MovementRpc, true, MeasureMovementPacketBits(Packet),
+			GetNetConnection());
+	}
+	ServerSendMovement(Packet);
+	if (!bHasSentMovement)
+	{
+		bHasSentMovement = true;
+		if (const auto SubmarineGameInstance = GetGameInstance<USubmarineGameInstance>())
+		{
+			SubmarineGameInstance->MarkJoinPhase(ESubmarineJoinPhase::FirstMovement);
+		}
+	}
 }
 
 float ASubmarinePawn::Now() const
@@ -150,101 +318,295 @@ void ASubmarinePawn::OnRep_Move()
 {
 	if (IsLocallyControlled())
 	{
-		UE_LOG(LogTemp, Error, TEXT("We should not be simulating movement if locally controlled!"))
+		SUBMARINE_LOG_RATE_LIMITED(1.0, LogSubmarineNet, Error,
+			TEXT("%s should not be simulating movement if locally controlled!"), *GetNetDebugName());
 		return;
 	}
-	//UE_LOG(LogTemp, Log, TEXT("%s applying update from Server Movement"), *NetDebugName);
+	if (FSubmarineNetStats::IsEnabled())
+	{
+		FSubmarineNetStats::Record(ESubmarineNetStat::ServerMovement, false, MeasureMovementBits(ServerMovement),
+			GetServerConnection(this));
+	}
+	RecordMovementArrival(ServerMovement);
+	//UE_LOG(LogTemp, Log, TEXT("%s applying update from Server Movement"), *GetNetDebugName());
 	// const auto ServerDeltaTime = Now() - ServerMovement.Timestamp;
 	// const auto Displacement = ServerMovement.Velocity * ServerDeltaTime;
-	LastTimestampApplied = ServerMovement.Timestamp;
-	RootComponent->SetWorldLocation(ServerMovement.Position);
-	RootComponent->SetWorldRotation(ServerMovement.Orientation);
-	GetMovementComponent()->Velocity = ServerMovement.Velocity;
+	if (const auto ProxyMovement = GetWorld()->GetSubsystem<USubmarineProxyMovementSubsystem>())
+	{
+		ProxyMovement->SetState(this, ServerMovement);
+	}
+	ApplyExtrapolatedMovement(ServerMovement.Position, ServerMovement);
 }
 
-void ASubmarinePawn::ServerSetTransform_Implementation(
-	const float Timestamp,
-	const FVector_NetQuantize Position,
-	const FQuat Rotation,
-	const FVector_NetQuantize NewVelocity
-	)
+void ASubmarinePawn::ServerSendMovement_Implementation(const FSubmarineMovementPacket& Packet)
 {
-	//UE_LOG(LogTemp, Log, TEXT("%s executing RPC"), *NetDebugName);
-	const auto CurrentTime = Now();
-	float DeltaTime = CurrentTime - Timestamp;
-	if (DeltaTime < -FLT_EPSILON)
+	LLM_SCOPE_BYTAG(Submarine_Pawn);
+	//UE_LOG(LogTemp, Log, TEXT("%s executing RPC"), *GetNetDebugName());
+	// Before the budget, the bits came in whether or not we drop them
+	if (FSubmarineNetStats::IsEnabled() && !IsLocallyControlled())
 	{
-		// This seems to happen quite a lot when clients/servers are first connected
-		// UE_LOG(LogTemp, Warning, TEXT("Received an update from %f in the future? Assuming 0 DeltaTime"),
-		// 	-DeltaTime)
-		DeltaTime = 0.f;
+		FSubmarineNetStats::Record(ESubmarineNetStat::MovementRpc, false, MeasureMovementPacketBits(Packet),
+			GetNetConnection());
 	}
-	
-	//const FVector_NetQuantize CurrentPosition = Position + (NewVelocity * DeltaTime);
-	
-	// Check if we are ALSO a local player in addition to a server, only move self if not locally controlled
-	if (!IsLocallyControlled())
+	// Movement goes up every frame, so a dropped one is replaced by the next
+	const auto SubmarineController = GetController<ASubmarinePlayerController>();
+	if (SubmarineController && !SubmarineController->ConsumeServerRpcBudget())
+	{
+		return;
+	}
+	// Unreliable packets can arrive out of order, and everything in an older one has been seen already. Going by
+	// sequence rather than timestamp means a Client whose clock gets corrected backwards doesn't freeze.
+	if (bHasReceivedMovementSequence && static_cast<int16>(Packet.Sequence - LastMovementSequenceReceived) <= 0)
 	{
-		// TODO: We could extrapolate forward in ServerTime with a sweep to detect collision
-		RootComponent->SetWorldLocation(Position);
-		// TODO: Really would like an angular velocity here too...
-		RootComponent->SetWorldRotation(Rotation);
-		GetMovementComponent()->Velocity = NewVelocity;
+		return;
 	}
+	bHasReceivedMovementSequence = true;
+	LastMovementSequenceReceived = Packet.Sequence;
+	RecordMovementArrival(Packet.State);
 
-	// Not sure which of these two methods guarantees Replication... both seem to break pretty regularly
-	//ServerMovement = FRepFloatingMovement(CurrentTime, CurrentPosition, Rotation, NewVelocity);
-	ServerMovement.Timestamp = Timestamp;
-	ServerMovement.Position = Position;
-	ServerMovement.Orientation = Rotation;
-	ServerMovement.Velocity = NewVelocity;
+	// Timestamps are the Client's idea of Server time. One from too far ahead would have proxies extrapolating
+	// backwards, so pull it in to a little past now.
+	FRepFloatingMovement Newest = Packet.State;
+	Newest.Timestamp = FMath::Min(Newest.Timestamp, Now() + MaxMovementTimestampLead);
+
+	// A listen server's own Pawn already moved locally, it just needs to replicate
+	if (IsLocallyControlled())
+	{
+		UpdateNetIdleState(Newest);
+		ServerMovement = Newest;
+		return;
+	}
+	// Applied by the subsystem next tick, so several packets landing in one frame only cost one move
+	if (const auto ProxyMovement = GetWorld()->GetSubsystem<USubmarineProxyMovementSubsystem>())
+	{
+		ProxyMovement->SetReceivedState(this, Newest);
+	}
 }
 
+void ASubmarinePawn::ApplyReceivedMovement(const FRepFloatingMovement& Movement)
+{
+	if (IsLocallyControlled())
+	{
+		return;
+	}
+	// TODO: We could extrapolate forward in ServerTime with a sweep to detect collision
+	// TODO: Really would like an angular velocity here too...
+	UpdateNetIdleState(Movement);
+	ServerMovement = Movement;
+	ApplyExtrapolatedMovement(Movement.Position, Movement);
+}
 
-void ASubmarinePawn::Tick(float DeltaTime)
+void ASubmarinePawn::RecordMovementArrival(const FRepFloatingMovement& Movement) const
 {
-	Super::Tick(DeltaTime);
+	if (!USubmarineNetQualitySubsystem::IsEnabled() || IsLocallyControlled())
+	{
+		return;
+	}
+	const auto NetQuality = GetWorld()->GetSubsystem<USubmarineNetQualitySubsystem>();
+	if (NetQuality == nullptr)
+	{
+		return;
+	}
+	NetQuality->RecordArrival(this);
+	const float Age = Now() - Movement.Timestamp;
+	if (Age < -FLT_EPSILON)
+	{
+		// Extrapolation treats these as "now". Happens quite a lot right after connecting.
+		NetQuality->Record(this, ESubmarineNetQualityMetric::FutureTimestamp, -Age * 1000.f);
+	}
+	// How far off our extrapolation was when the truth arrived. The first state has nothing to compare against.
+	if (LastTimestampApplied >= 0.f)
+	{
+		const FVector Expected = Movement.Position + Movement.Velocity * FMath::Clamp(Age, 0.f, ExtrapolationLimit);
+		NetQuality->Record(this, ESubmarineNetQualityMetric::SnapDistance,
+			FVector::Dist(GetActorLocation(), Expected));
+	}
+}
+
+void ASubmarinePawn::SetWeaponFiring(const USubmarineWeapon* Weapon, const bool bIsFiring, const float TimeStamp)
+{
+	const int32 WeaponIndex = Weapons.IndexOfByKey(Weapon);
+	if (WeaponIndex == INDEX_NONE || WeaponIndex >= MaxWeapons)
+	{
+		return;
+	}
+	const uint16 WeaponBit = 1 << WeaponIndex;
+	if (bIsFiring)
+	{
+		FiringState.FiringWeapons |= WeaponBit;
+		FiringState.PhaseTimestamp = TimeStamp;
+	}
+	else
+	{
+		FiringState.FiringWeapons &= ~WeaponBit;
+	}
+	// Firing state has to reach other Clients straight away, even if we were parked
+	WakeNetUpdates();
+}
+
+void ASubmarinePawn::OnRep_FiringState(const FSubmarineFiringState& PreviousFiringState)
+{
+	if (FSubmarineNetStats::IsEnabled())
+	{
+		FSubmarineNetStats::Record(ESubmarineNetStat::FiringState, false, MeasureFiringStateBits(FiringState),
+			GetServerConnection(this));
+	}
+	// The initial bunch gets here before BeginPlay, which applies it once the Weapons are set up
+	if (HasActorBegunPlay())
+	{
+		ApplyFiringState(PreviousFiringState);
+	}
+}
 
+void ASubmarinePawn::ApplyFiringState(const FSubmarineFiringState& PreviousFiringState)
+{
 	if (!bWeaponsAreInitialized)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Weapons failed to initialize in SetupPlayerInputComponent or BeginPlay."
-								" Doing it now."))
+		InitializeWeapons();
+	}
+	const uint16 ChangedWeapons = FiringState.FiringWeapons ^ PreviousFiringState.FiringWeapons;
+	for (int32 i = 0; i < FMath::Min(Weapons.Num(), MaxWeapons); ++i)
+	{
+		const uint16 WeaponBit = 1 << i;
+		if ((ChangedWeapons & WeaponBit) == 0)
+		{
+			continue;
+		}
+		if (FiringState.FiringWeapons & WeaponBit)
+		{
+			Weapons[i]->StartShootingRemote(FiringState.PhaseTimestamp);
+		}
+		else
+		{
+			Weapons[i]->StopShootingRemote();
+		}
 	}
+}
 
-	if (IsLocallyControlled())
+void ASubmarinePawn::ServerStartShooting_Implementation(const uint8 WeaponIndex, const float TimeStamp,
+	const FVector_NetQuantize CurrentPosition, const FQuat CurrentRotation, const FVector_NetQuantize10 CurrentVelocity)
+{
+	// Reliable, so it counts towards the connection's RPC budget but is never dropped
+	if (const auto SubmarineController = GetController<ASubmarinePlayerController>())
 	{
-		CalculateAndSendUpdates(DeltaTime);
+		SubmarineController->ConsumeServerRpcBudget(false);
 	}
-	else if (Now() - ServerMovement.Timestamp < ExtrapolationLimit)
+	if (FSubmarineNetStats::IsEnabled())
 	{
-		ApplyLastUpdate();
+		FSubmarineNetStats::Record(ESubmarineNetStat::StartShootingRpc, false,
+			MeasureStartShootingBits(WeaponIndex, TimeStamp, CurrentPosition, CurrentRotation, CurrentVelocity),
+			GetNetConnection());
 	}
-	else
+	if (Weapons.IsValidIndex(WeaponIndex))
 	{
-		// Might want to re-enable this once we're positive that things are stable...
-		//UE_LOG(LogTemp, Log, TEXT("%s doing nothing while we wait for a fresh movement update..."), *NetDebugName)
+		Weapons[WeaponIndex]->StartShootingOnServer(TimeStamp, CurrentPosition, CurrentRotation, CurrentVelocity);
 	}
+}
 
+void ASubmarinePawn::ServerStopShooting_Implementation(const uint8 WeaponIndex, const float TimeStamp)
+{
+	if (const auto SubmarineController = GetController<ASubmarinePlayerController>())
+	{
+		SubmarineController->ConsumeServerRpcBudget(false);
+	}
+	if (FSubmarineNetStats::IsEnabled())
+	{
+		FSubmarineNetStats::Record(ESubmarineNetStat::StopShootingRpc, false, StopShootingBits, GetNetConnection());
+	}
+	if (Weapons.IsValidIndex(WeaponIndex))
+	{
+		Weapons[WeaponIndex]->StopShootingOnServer(TimeStamp);
+	}
 }
 
-void ASubmarinePawn::ApplyLastUpdate()
+void ASubmarinePawn::SendStartShooting(const USubmarineWeapon* Weapon, const float TimeStamp,
+	const FVector_NetQuantize& CurrentPosition, const FQuat& CurrentRotation,
+	const FVector_NetQuantize10& CurrentVelocity)
 {
-	if (IsLocallyControlled())
+	const int32 WeaponIndex = Weapons.IndexOfByKey(Weapon);
+	if (WeaponIndex == INDEX_NONE || WeaponIndex >= MaxWeapons)
+	{
+		return;
+	}
+	if (FSubmarineNetStats::IsEnabled())
+	{
+		FSubmarineNetStats::Record(ESubmarineNetStat::StartShootingRpc, true,
+			MeasureStartShootingBits(static_cast<uint8>(WeaponIndex), TimeStamp, CurrentPosition, CurrentRotation,
+				CurrentVelocity),
+			GetNetConnection());
+	}
+	ServerStartShooting(static_cast<uint8>(WeaponIndex), TimeStamp, CurrentPosition, CurrentRotation, CurrentVelocity);
+}
+
+void ASubmarinePawn::SendStopShooting(const USubmarineWeapon* Weapon, const float TimeStamp)
+{
+	const int32 WeaponIndex = Weapons.IndexOfByKey(Weapon);
+	if (WeaponIndex == INDEX_NONE || WeaponIndex >= MaxWeapons)
 	{
-		UE_LOG(LogTemp, Error, TEXT("We should not be simulating movement if locally controlled!"))
 		return;
 	}
-	//UE_LOG(LogTemp, Log, TEXT("%s applying update from Server Movement"), *NetDebugName);
-	float ServerDeltaTime = Now() - ServerMovement.Timestamp;
-	if (ServerDeltaTime < 0)
+	if (FSubmarineNetStats::IsEnabled())
 	{
-		ServerDeltaTime = 0;
+		FSubmarineNetStats::Record(ESubmarineNetStat::StopShootingRpc, true, StopShootingBits, GetNetConnection());
 	}
-	const auto Displacement = ServerMovement.Velocity * ServerDeltaTime;
-	LastTimestampApplied = ServerMovement.Timestamp;
-	RootComponent->SetWorldLocation(ServerMovement.Position + Displacement);
-	RootComponent->SetWorldRotation(ServerMovement.Orientation);
-	GetMovementComponent()->Velocity = ServerMovement.Velocity;
+	ServerStopShooting(static_cast<uint8>(WeaponIndex), TimeStamp);
+}
+
+void ASubmarinePawn::UpdateNetIdleState(const FRepFloatingMovement& Movement)
+{
+	// ServerMovement changes with every state, so comparing against it would let a slow turn look parked
+	const bool bIsMoving = Movement.Velocity.SizeSquared() > FMath::Square(IdleSpeedThreshold)
+		|| Movement.Orientation.AngularDistance(LastActiveOrientation) > IdleAngleThreshold;
+	if (bIsMoving)
+	{
+		LastActiveOrientation = Movement.Orientation;
+		WakeNetUpdates();
+		return;
+	}
+	if (!bIsNetIdle && GetWorld()->GetTimeSeconds() - TimeLastNetActive > IdleNetUpdateDelay)
+	{
+		bIsNetIdle = true;
+		NetUpdateFrequency = IdleNetUpdateFrequency;
+	}
+}
+
+void ASubmarinePawn::WakeNetUpdates()
+{
+	TimeLastNetActive = GetWorld()->GetTimeSeconds();
+	if (bIsNetIdle)
+	{
+		bIsNetIdle = false;
+		NetUpdateFrequency = ActiveNetUpdateFrequency;
+		// Don't wait out the rest of the idle interval
+		ForceNetUpdate();
+	}
+}
+
+
+void ASubmarinePawn::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (!bWeaponsAreInitialized)
+	{
+		SUBMARINE_LOG_RATE_LIMITED(5.0, LogSubmarine, Warning,
+			TEXT("Weapons failed to initialize in SetupPlayerInputComponent or BeginPlay. Doing it now."));
+	}
+
+	// Remote Pawns are moved by USubmarineProxyMovementSubsystem
+	if (IsLocallyControlled())
+	{
+		CalculateAndSendUpdates(DeltaTime);
+	}
+}
+
+void ASubmarinePawn::ApplyExtrapolatedMovement(const FVector& Position, const FRepFloatingMovement& Movement)
+{
+	LastTimestampApplied = Movement.Timestamp;
+	// One combined transform update instead of separate location and rotation updates
+	RootComponent->SetWorldLocationAndRotation(Position, Movement.Orientation, false, nullptr,
+		ETeleportType::TeleportPhysics);
+	GetMovementComponent()->Velocity = Movement.Velocity;
 }
 
 
@@ -254,7 +616,7 @@ void ASubmarinePawn::SetupPlayerInputComponent(UInputComponent* PlayerInputCompo
 	const auto SubmarineController = Cast<ASubmarinePlayerController>(Controller);
 	if (SubmarineController == nullptr)
 	{
-		UE_LOG(LogTemp, Error, TEXT("Player Controller not set to ASubmarinePlayerController"))
+		UE_LOG(LogSubmarine, Error, TEXT("Player Controller not set to ASubmarinePlayerController"))
 	}
 	else if(APlayerController* PlayerController = Cast<APlayerController>(Controller))
 	{
@@ -287,9 +649,14 @@ void ASubmarinePawn::InitializeWeapons()
 	GetComponents<USubmarineWeapon>(Weapons);
 	if (Weapons.Num() == 0)
 	{
-		UE_LOG(LogTemp, Error, TEXT("Found no Weapons! Can't initialize Weapon actions..."));
+		UE_LOG(LogSubmarine, Error, TEXT("Found no Weapons! Can't initialize Weapon actions..."));
 		return;
 	}
+	if (Weapons.Num() > MaxWeapons)
+	{
+		UE_LOG(LogSubmarine, Error, TEXT("%s has %d Weapons, only the first %d will replicate their firing state"),
+			*GetName(), Weapons.Num(), MaxWeapons);
+	}
 	for (const auto& Weapon: Weapons)
 	{
 		Weapon->BindToPlayer(Camera);
@@ -344,11 +711,11 @@ void ASubmarinePawn::OnRep_Juggernaut()
 {
 	if (bIsJuggernaut)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("%s is now the Juggernaut!"), *GetActorNameOrLabel())
+		UE_LOG(LogSubmarine, Warning, TEXT("%s is now the Juggernaut!"), *GetActorNameOrLabel())
 	}
 	else
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Called OnRep_Juggernaut even though we're not!"))
+		UE_LOG(LogSubmarine, Warning, TEXT("Called OnRep_Juggernaut even though we're not!"))
 		return;
 	}
 	CurrentDashCooldown = JuggernautDashCooldown;
@@ -384,7 +751,7 @@ void ASubmarinePawn::Dash(const FInputActionValue& ActionValue)
 	}
 	if (!CanDash())
 	{
-		UE_LOG(LogTemp, Log, TEXT("In Dash cooldown; can't dash."))
+		UE_LOG(LogSubmarine, Log, TEXT("In Dash cooldown; can't dash."))
 		return;
 	}
 	
@@ -409,7 +776,7 @@ void ASubmarinePawn::JuggernautDash(const FInputActionValue& ActionValue)
 	const bool bIsButtonPressed = ActionValue.Get<bool>();
 	if (bIsButtonPressed && CanDash())
 	{
-		UE_LOG(LogTemp, Log, TEXT("Charging up Juggernaut Dash"));
+		UE_LOG(LogSubmarine, Log, TEXT("Charging up Juggernaut Dash"));
 		bIsChargingSuperDash = true;
 		TimeJuggernautDashChargingStarted = GetWorld()->GetTimeSeconds();
 	}
@@ -417,7 +784,7 @@ void ASubmarinePawn::JuggernautDash(const FInputActionValue& ActionValue)
 	{
 		if (CanDash() || !bIsChargingSuperDash)
 		{
-			UE_LOG(LogTemp, Warning, TEXT("Got a Dash Completed event but Pawn can still dash???"))
+			UE_LOG(LogSubmarine, Warning, TEXT("Got a Dash Completed event but Pawn can still dash???"))
 			return;
 		}
 		const float ValidChargeThreshold = JuggernautDashChargeDuration * 0.25f;
@@ -425,14 +792,14 @@ void ASubmarinePawn::JuggernautDash(const FInputActionValue& ActionValue)
 		const float TimeSpentCharging = GetWorld()->GetTimeSeconds() - TimeJuggernautDashChargingStarted;
 		if (TimeSpentCharging < ValidChargeThreshold)
 		{
-			UE_LOG(LogTemp, Log, TEXT("Juggernaut Dash cancelled"));
+			UE_LOG(LogSubmarine, Log, TEXT("Juggernaut Dash cancelled"));
 			bIsDashing = false;
 			bIsChargingSuperDash = false;
 		}
 		else if (TimeSpentCharging < ChargeWaitThreshold)
 		{
 			const float RemainingWaitTime = ChargeWaitThreshold - TimeSpentCharging;
-			UE_LOG(LogTemp, Log, TEXT("Juggernaut Dash locked in, will execute in %f seconds"), RemainingWaitTime);
+			UE_LOG(LogSubmarine, Log, TEXT("Juggernaut Dash locked in, will execute in %f seconds"), RemainingWaitTime);
 			GetWorld()->GetTimerManager().SetTimer(
 				DashEndTimerHandle, this, &ASubmarinePawn::DoJuggernautDash, RemainingWaitTime, false);
 		}
@@ -445,7 +812,7 @@ void ASubmarinePawn::JuggernautDash(const FInputActionValue& ActionValue)
 
 void ASubmarinePawn::DoJuggernautDash()
 {
-	UE_LOG(LogTemp, Log, TEXT("Doing Juggernaut Dash"));
+	UE_LOG(LogSubmarine, Log, TEXT("Doing Juggernaut Dash"));
 	bIsChargingSuperDash = false;
 	bIsDashing = true;
 
@@ -2,27 +2,68 @@
 
 #include "CoreMinimal.h"
 #include "RepFloatingMovement.h"
+#include "SubmarineMovementPacket.h"
 #include "GameFramework/Pawn.h"
 #include "SubmarinePawn.generated.h"
 
 class USubmarineWeapon;
+class USubmarineProxyMovementSubsystem;
 struct FInputActionValue;
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FStartedDash);
 
+// Every weapon's firing state in one property, so a Pawn is a single replicated object no matter how many barrels it has
+USTRUCT()
+struct FSubmarineFiringState
+{
+	GENERATED_BODY()
+
+	// Bit i is set while ASubmarinePawn::Weapons[i] is firing
+	UPROPERTY()
+	uint16 FiringWeapons = 0;
+
+	// When the most recent weapon started firing, so proxies fire in phase with the Server's shots
+	UPROPERTY()
+	float PhaseTimestamp = 0.f;
+};
+
 UCLASS()
 class ANTIQUATEDFUTURE_API ASubmarinePawn : public APawn
 {
 	GENERATED_BODY()
 
+	friend class USubmarineProxyMovementSubsystem;
+
 // ------ MOVEMENT REPLICATION CODE --------
 protected:
-	const float ExtrapolationLimit = 0.1f;
+	static constexpr float ExtrapolationLimit = 0.1f;
 	bool bHasWarnedAuthority;
 	bool bWeaponsAreInitialized;
+	bool bHasSentMovement;
 	float LastTimestampApplied;
-
-	FString NetDebugName;
+	uint16 NextMovementSequence;
+	// Server: newest packet from the owning Client so far. Starts over whenever the Controller changes.
+	bool bHasReceivedMovementSequence;
+	uint16 LastMovementSequenceReceived;
+	// Server: how far past our clock a Client's movement timestamp may be before we pull it back
+	static constexpr float MaxMovementTimestampLead = 0.1f;
+	// Server: a parked, quiet sub only replicates at IdleNetUpdateFrequency. Real dormancy would close the actor
+	// channel, and with it the owning Client's way of sending us movement and weapon RPCs.
+	bool bIsNetIdle;
+	float ActiveNetUpdateFrequency;
+	float TimeLastNetActive;
+	// Where we were pointing the last time we counted as moving, so turns add up rather than being judged per state
+	FQuat LastActiveOrientation;
+	void UpdateNetIdleState(const FRepFloatingMovement& Movement);
+	// Server: what PreReplication last counted towards net stats, so each change is only counted once
+	float LastMeasuredMovementTimestamp;
+	uint16 LastMeasuredFiringWeapons;
+	float LastMeasuredFirePhase;
+	// Where this Pawn's state lives in USubmarineProxyMovementSubsystem, if it's remotely controlled
+	int32 ProxyMovementIndex;
+
+	// Only built when something actually logs it
+	FString GetNetDebugName() const;
 	
 	// Not a UENUM so need custom function
 	FString ToString(ENetMode NetMode) const;
@@ -33,22 +74,67 @@ protected:
 	TWeakObjectPtr<AGameStateBase> GameState;
 	void CalculateAndSendUpdates(float DeltaTime);
 	void InitializeWeapons();
-	void ApplyLastUpdate();
+	// Starts and stops remote fire for every weapon whose bit changed since PreviousFiringState
+	void ApplyFiringState(const FSubmarineFiringState& PreviousFiringState);
+	// Called in a batch by USubmarineProxyMovementSubsystem instead of from our own Tick
+	void ApplyExtrapolatedMovement(const FVector& Position, const FRepFloatingMovement& Movement);
+	// Server: the newest state the owning Client sent this frame
+	void ApplyReceivedMovement(const FRepFloatingMovement& Movement);
+	// Feeds USubmarineNetQualitySubsystem whenever a fresh state for this proxy shows up
+	void RecordMovementArrival(const FRepFloatingMovement& Movement) const;
 
 public:
 	ASubmarinePawn();
 
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
 
 	UFUNCTION(Server, Unreliable)
-	void ServerSetTransform(const float Timestamp,
-		const FVector_NetQuantize Position,
-		const FQuat Rotation,
-		const FVector_NetQuantize NewVelocity
-		);
+	void ServerSendMovement(const FSubmarineMovementPacket& Packet);
 
 	bool IsLocalControl() const;
 	bool IsAuthority() const;
+	const TArray<USubmarineWeapon*>& GetWeapons() const { return Weapons; }
+	// Server: back to full rate replication right away, e.g. because a weapon started firing
+	void WakeNetUpdates();
+
+	static constexpr int32 MaxWeapons = 16;
+	UPROPERTY(ReplicatedUsing=OnRep_FiringState)
+	FSubmarineFiringState FiringState;
+	UFUNCTION()
+	void OnRep_FiringState(const FSubmarineFiringState& PreviousFiringState);
+	// Server
+	void SetWeaponFiring(const USubmarineWeapon* Weapon, const bool bIsFiring, const float TimeStamp);
+
+	// Weapons address themselves by their index in GetWeapons(), which comes from the same Blueprint on every machine
+	UFUNCTION(Server, Reliable)
+	void ServerStartShooting(
+		const uint8 WeaponIndex,
+		const float TimeStamp,
+		const FVector_NetQuantize CurrentPosition,
+		const FQuat CurrentRotation,
+		const FVector_NetQuantize10 CurrentVelocity);
+	UFUNCTION(Server, Reliable)
+	void ServerStopShooting(const uint8 WeaponIndex, const float TimeStamp);
+	// What weapons call on owning Clients, rather than the RPCs directly
+	void SendStartShooting(
+		const USubmarineWeapon* Weapon,
+		const float TimeStamp,
+		const FVector_NetQuantize& CurrentPosition,
+		const FQuat& CurrentRotation,
+		const FVector_NetQuantize10& CurrentVelocity);
+	void SendStopShooting(const USubmarineWeapon* Weapon, const float TimeStamp);
+
+	// Slower than this (and not turning) counts as parked
+	UPROPERTY(EditAnywhere)
+	float IdleSpeedThreshold = 10.f;
+	UPROPERTY(EditAnywhere)
+	float IdleAngleThreshold = 0.01f;
+	// How long a sub must stay parked before it drops to IdleNetUpdateFrequency
+	UPROPERTY(EditAnywhere)
+	float IdleNetUpdateDelay = 1.f;
+	UPROPERTY(EditAnywhere)
+	float IdleNetUpdateFrequency = 2.f;
 	
 	// UPROPERTY(Replicated)
 	// bool bHasReceivedMovement;
@@ -65,8 +151,10 @@ public:
 	
 
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 	virtual void Tick(float DeltaTime) override;
+	virtual void NotifyControllerChanged() override;
 
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 	void Move(const FInputActionValue& ActionValue);
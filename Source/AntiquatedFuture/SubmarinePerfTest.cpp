@@ -0,0 +1,477 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SubmarinePerfTest.h"
+#include "AntiquatedFuture.h"
+#include "EngineUtils.h"
+#include "InputActionValue.h"
+#include "SubmarinePawn.h"
+#include "SubmarineWeapons.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerStart.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+bool USubmarinePerfTestSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	return FParse::Param(FCommandLine::Get(), TEXT("SubmarinePerfTest")) && Super::ShouldCreateSubsystem(Outer);
+}
+
+bool USubmarinePerfTestSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId USubmarinePerfTestSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USubmarinePerfTestSubsystem, STATGROUP_Tickables);
+}
+
+void USubmarinePerfTestSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+	const TCHAR* CommandLine = FCommandLine::Get();
+	if (FParse::Param(CommandLine, TEXT("SubmarinePerfClient")))
+	{
+		// Only the match we connected to, not the menu we fall back to once the Server goes away
+		if (InWorld.GetNetMode() == NM_Client)
+		{
+			int32 Seed = 1;
+			FParse::Value(CommandLine, TEXT("SubmarinePerfSeed="), Seed);
+			Random.Initialize(0x5B + Seed);
+			bIsClient = true;
+			bIsRunning = true;
+		}
+		return;
+	}
+
+	// The menu map comes through here too. Only a Server running a match has anything to measure.
+	const auto GameMode = InWorld.GetAuthGameMode();
+	if (InWorld.GetNetMode() == NM_Client || GameMode == nullptr || GameMode->DefaultPawnClass == nullptr ||
+		!GameMode->DefaultPawnClass->IsChildOf<ASubmarinePawn>())
+	{
+		return;
+	}
+
+	FParse::Value(CommandLine, TEXT("SubmarinePerfBots="), NumBots);
+	FParse::Value(CommandLine, TEXT("SubmarinePerfClients="), NumClients);
+	FParse::Value(CommandLine, TEXT("SubmarinePerfConnectTimeout="), ClientConnectTimeout);
+	FParse::Value(CommandLine, TEXT("SubmarinePerfWarmup="), WarmupSeconds);
+	FParse::Value(CommandLine, TEXT("SubmarinePerfDuration="), DurationSeconds);
+	FParse::Value(CommandLine, TEXT("SubmarinePerfTolerance="), Tolerance);
+	bUpdateBaseline = FParse::Param(CommandLine, TEXT("SubmarinePerfUpdateBaseline"));
+	if (!FParse::Value(CommandLine, TEXT("SubmarinePerfBaseline="), BaselinePath))
+	{
+		BaselinePath = FPaths::ProjectDir() / TEXT("Build/SubmarinePerfBaseline.txt");
+	}
+	// Same seed every run, so every run plays out the same fight
+	Random.Initialize(0x5B);
+
+	SpawnBots(InWorld);
+	LaunchClients(InWorld);
+	UE_LOG(LogSubmarine, Display, TEXT("Perf test: %d bots, %d clients, %.0f s warmup, %.0f s measured"), Bots.Num(),
+		NumClients, WarmupSeconds, DurationSeconds)
+
+	TickStartHandle = FWorldDelegates::OnWorldTickStart.AddUObject(this, &USubmarinePerfTestSubsystem::OnWorldTickStart);
+	PreActorTickHandle = FWorldDelegates::OnWorldPreActorTick.AddUObject(
+		this, &USubmarinePerfTestSubsystem::OnWorldPreActorTick);
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(
+		this, &USubmarinePerfTestSubsystem::OnWorldPostActorTick);
+	PostTickFlushHandle = InWorld.OnPostTickFlush().AddUObject(this, &USubmarinePerfTestSubsystem::OnPostTickFlush);
+	EndFrameHandle = FCoreDelegates::OnEndFrame.AddUObject(this, &USubmarinePerfTestSubsystem::OnEndFrame);
+
+	const int32 ExpectedFrames = FMath::CeilToInt(DurationSeconds * 120.f);
+	FrameTimeSamples.Reserve(ExpectedFrames);
+	NetTickSamples.Reserve(ExpectedFrames);
+	ActorCountSamples.Reserve(ExpectedFrames);
+	ConnectStartTime = FPlatformTime::Seconds();
+	bIsRunning = true;
+}
+
+void USubmarinePerfTestSubsystem::Deinitialize()
+{
+	UnbindDelegates();
+	TerminateClients();
+	Super::Deinitialize();
+}
+
+void USubmarinePerfTestSubsystem::UnbindDelegates()
+{
+	FWorldDelegates::OnWorldTickStart.Remove(TickStartHandle);
+	FWorldDelegates::OnWorldPreActorTick.Remove(PreActorTickHandle);
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	if (const auto World = GetWorld())
+	{
+		World->OnPostTickFlush().Remove(PostTickFlushHandle);
+	}
+	FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+}
+
+void USubmarinePerfTestSubsystem::SpawnBots(UWorld& InWorld)
+{
+	TArray<FTransform> Starts;
+	for (TActorIterator<APlayerStart> It(&InWorld); It; ++It)
+	{
+		Starts.Add(It->GetActorTransform());
+	}
+	if (Starts.Num() == 0)
+	{
+		Starts.Add(FTransform::Identity);
+	}
+
+	const auto PawnClass = InWorld.GetAuthGameMode()->DefaultPawnClass;
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+	Bots.Reserve(NumBots);
+	for (int32 i = 0; i < NumBots; ++i)
+	{
+		// Spread out around the starts so they aren't all stacked inside each other
+		FTransform SpawnTransform = Starts[i % Starts.Num()];
+		SpawnTransform.AddToTranslation(Random.VRand() * Random.FRandRange(200.f, 1500.f));
+		const auto Pawn = InWorld.SpawnActor<ASubmarinePawn>(PawnClass, SpawnTransform, SpawnParameters);
+		if (Pawn == nullptr)
+		{
+			UE_LOG(LogSubmarine, Warning, TEXT("Perf test couldn't spawn bot %d"), i)
+			continue;
+		}
+		// An AI Controller makes the Pawn locally controlled on the Server, so it runs the same path a listen host does
+		Pawn->SpawnDefaultController();
+		if (Pawn->GetController() == nullptr)
+		{
+			UE_LOG(LogSubmarine, Warning, TEXT("Perf test bot %s has no AI Controller and won't move"),
+				*Pawn->GetName())
+		}
+		FBot& Bot = Bots.AddDefaulted_GetRef();
+		Bot.Pawn = Pawn;
+		Bot.NextDashTime = Random.FRandRange(1.f, 4.f);
+		Bot.NextFireToggleTime = Random.FRandRange(0.f, 2.f);
+	}
+}
+
+void USubmarinePerfTestSubsystem::LaunchClients(const UWorld& InWorld)
+{
+	if (NumClients <= 0)
+	{
+		return;
+	}
+	FString Executable;
+	FString Params;
+	if (!FParse::Value(FCommandLine::Get(), TEXT("SubmarinePerfClientExe="), Executable))
+	{
+		// A packaged server has no client code in it, but an uncooked editor binary can be either
+		if (FPlatformProperties::RequiresCookedData())
+		{
+			UE_LOG(LogSubmarine, Warning,
+				TEXT("Perf test needs -SubmarinePerfClientExe=<client build> to launch clients, running without any"))
+			NumClients = 0;
+			return;
+		}
+		Executable = FPlatformProcess::ExecutablePath();
+		Params = FString::Printf(TEXT("\"%s\" -game "),
+			*FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath()));
+	}
+	// Plain IP over loopback, and the Null subsystem so nothing tries to sign in
+	Params += FString::Printf(TEXT("127.0.0.1:%d -nullrhi -unattended -nosound -nosplash -nosteam -SubmarineTestOnline ")
+		TEXT("-SubmarinePerfTest -SubmarinePerfClient"), InWorld.URL.Port);
+
+	for (int32 i = 0; i < NumClients; ++i)
+	{
+		const FString ClientParams = Params + FString::Printf(TEXT(" -SubmarinePerfSeed=%d -log=SubmarinePerfClient%d.log"),
+			i + 1, i);
+		FProcHandle Process = FPlatformProcess::CreateProc(*Executable, *ClientParams, false, true, true, nullptr, 0,
+			nullptr, nullptr);
+		if (!Process.IsValid())
+		{
+			UE_LOG(LogSubmarine, Error, TEXT("Perf test couldn't launch client %d: %s %s"), i, *Executable,
+				*ClientParams)
+			continue;
+		}
+		ClientProcesses.Add(Process);
+	}
+	NumClients = ClientProcesses.Num();
+}
+
+void USubmarinePerfTestSubsystem::TerminateClients()
+{
+	for (FProcHandle& Process: ClientProcesses)
+	{
+		if (FPlatformProcess::IsProcRunning(Process))
+		{
+			FPlatformProcess::TerminateProc(Process, true);
+		}
+		FPlatformProcess::CloseProc(Process);
+	}
+	ClientProcesses.Reset();
+}
+
+int32 USubmarinePerfTestSubsystem::GetNumConnectedClients() const
+{
+	const UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	if (NetDriver == nullptr)
+	{
+		return 0;
+	}
+	int32 NumConnected = 0;
+	for (const UNetConnection* Connection: NetDriver->ClientConnections)
+	{
+		if (Connection && Connection->PlayerController && Connection->PlayerController->GetPawn<ASubmarinePawn>())
+		{
+			++NumConnected;
+		}
+	}
+	return NumConnected;
+}
+
+void USubmarinePerfTestSubsystem::DriveBot(FBot& Bot, const double Now)
+{
+	ASubmarinePawn* Pawn = Bot.Pawn.Get();
+	if (Pawn == nullptr)
+	{
+		return;
+	}
+	if (Now >= Bot.NextSteerTime)
+	{
+		Bot.MoveInput = FVector(Random.FRandRange(0.2f, 1.f), Random.FRandRange(-1.f, 1.f),
+			Random.FRandRange(-0.5f, 0.5f));
+		Bot.RotateInput = FVector(Random.FRandRange(-1.f, 1.f), Random.FRandRange(-1.f, 1.f),
+			Random.FRandRange(-0.2f, 0.2f));
+		Bot.NextSteerTime = Now + Random.FRandRange(0.5f, 2.f);
+	}
+	Pawn->Move(FInputActionValue(Bot.MoveInput));
+	Pawn->Rotate(FInputActionValue(Bot.RotateInput));
+
+	if (Now >= Bot.NextDashTime)
+	{
+		Pawn->Dash(FInputActionValue(true));
+		Bot.NextDashTime = Now + Random.FRandRange(3.f, 8.f);
+	}
+
+	// Hold the trigger for a while, then let go, like players do
+	if (Now >= Bot.NextFireToggleTime)
+	{
+		Bot.bIsFiring = !Bot.bIsFiring;
+		Bot.NextFireToggleTime = Now + (Bot.bIsFiring ? Random.FRandRange(1.f, 4.f) : Random.FRandRange(0.5f, 2.f));
+		if (!Bot.bIsFiring)
+		{
+			for (const auto Weapon: Pawn->GetWeapons())
+			{
+				Weapon->HandleShootAction(FInputActionValue(false));
+			}
+		}
+	}
+	if (Bot.bIsFiring)
+	{
+		// Input triggers every frame the button is held
+		for (const auto Weapon: Pawn->GetWeapons())
+		{
+			Weapon->HandleShootAction(FInputActionValue(true));
+		}
+	}
+}
+
+void USubmarinePerfTestSubsystem::DriveLocalPawn(const double Now)
+{
+	const auto PlayerController = GetWorld()->GetFirstPlayerController();
+	ASubmarinePawn* Pawn = PlayerController ? PlayerController->GetPawn<ASubmarinePawn>() : nullptr;
+	if (Pawn == nullptr)
+	{
+		return;
+	}
+	// Respawned, or the first Pawn we've been given
+	if (Bots.Num() == 0 || Bots[0].Pawn.Get() != Pawn)
+	{
+		Bots.Reset();
+		FBot& Bot = Bots.AddDefaulted_GetRef();
+		Bot.Pawn = Pawn;
+		Bot.NextDashTime = Now + Random.FRandRange(1.f, 4.f);
+		Bot.NextFireToggleTime = Now + Random.FRandRange(0.f, 2.f);
+	}
+	DriveBot(Bots[0], Now);
+}
+
+void USubmarinePerfTestSubsystem::Tick(float DeltaTime)
+{
+	if (!bIsRunning)
+	{
+		return;
+	}
+	const double Now = GetWorld()->GetTimeSeconds();
+	if (bIsClient)
+	{
+		DriveLocalPawn(Now);
+		return;
+	}
+	for (FBot& Bot: Bots)
+	{
+		DriveBot(Bot, Now);
+	}
+
+	const double CurrentTime = FPlatformTime::Seconds();
+	if (StartTime < 0.0)
+	{
+		const int32 NumConnected = GetNumConnectedClients();
+		if (NumConnected >= NumClients)
+		{
+			UE_LOG(LogSubmarine, Display, TEXT("Perf test: %d clients in after %.1f s, warming up"), NumConnected,
+				CurrentTime - ConnectStartTime)
+			StartTime = CurrentTime;
+		}
+		else if (CurrentTime - ConnectStartTime > ClientConnectTimeout)
+		{
+			UE_LOG(LogSubmarine, Error, TEXT("Perf test only got %d of %d clients in after %.0f s"), NumConnected,
+				NumClients, ClientConnectTimeout)
+			Finish();
+		}
+		return;
+	}
+	if (CurrentTime - StartTime >= WarmupSeconds + DurationSeconds)
+	{
+		Finish();
+	}
+}
+
+void USubmarinePerfTestSubsystem::OnWorldTickStart(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (InWorld != GetWorld())
+	{
+		return;
+	}
+	FrameStartTime = FPlatformTime::Seconds();
+	PreActorTickTime = FrameStartTime;
+	PostActorTickTime = FrameStartTime;
+	NetTickMs = 0.0;
+}
+
+void USubmarinePerfTestSubsystem::OnWorldPreActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (InWorld == GetWorld())
+	{
+		PreActorTickTime = FPlatformTime::Seconds();
+		NetTickMs += (PreActorTickTime - FrameStartTime) * 1000.0;
+	}
+}
+
+void USubmarinePerfTestSubsystem::OnWorldPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (InWorld == GetWorld())
+	{
+		PostActorTickTime = FPlatformTime::Seconds();
+	}
+}
+
+void USubmarinePerfTestSubsystem::OnPostTickFlush()
+{
+	NetTickMs += (FPlatformTime::Seconds() - PostActorTickTime) * 1000.0;
+}
+
+void USubmarinePerfTestSubsystem::OnEndFrame()
+{
+	// Nothing counts until every client is in and the warmup is over
+	if (!bIsRunning || FrameStartTime <= 0.0 || StartTime < 0.0
+		|| FPlatformTime::Seconds() - StartTime < WarmupSeconds)
+	{
+		return;
+	}
+	FrameTimeSamples.Add((FPlatformTime::Seconds() - FrameStartTime) * 1000.0);
+	NetTickSamples.Add(NetTickMs);
+	ActorCountSamples.Add(GetWorld()->GetActorCount());
+}
+
+USubmarinePerfTestSubsystem::FPercentiles USubmarinePerfTestSubsystem::ComputePercentiles(TArray<double>& Samples)
+{
+	FPercentiles Result;
+	if (Samples.Num() == 0)
+	{
+		return Result;
+	}
+	Samples.Sort();
+	const auto At = [&Samples](const double Fraction)
+	{
+		return Samples[FMath::Clamp(FMath::CeilToInt(Fraction * Samples.Num()) - 1, 0, Samples.Num() - 1)];
+	};
+	Result.P50 = At(0.50);
+	Result.P95 = At(0.95);
+	Result.P99 = At(0.99);
+	return Result;
+}
+
+bool USubmarinePerfTestSubsystem::ReportMetric(
+	const TCHAR* Name, TArray<double>& Samples, const FString& Baseline, FString& OutResults) const
+{
+	const FPercentiles Percentiles = ComputePercentiles(Samples);
+	const TPair<const TCHAR*, double> Values[] = {
+		{TEXT("p50"), Percentiles.P50}, {TEXT("p95"), Percentiles.P95}, {TEXT("p99"), Percentiles.P99}};
+	bool bPassed = true;
+	for (const auto& Value: Values)
+	{
+		const FString Key = FString::Printf(TEXT("%s.%s"), Name, Value.Key);
+		OutResults += FString::Printf(TEXT("%s=%.3f") LINE_TERMINATOR, *Key, Value.Value);
+
+		double BaselineValue = 0.0;
+		if (!FParse::Value(*Baseline, *(Key + TEXT("=")), BaselineValue))
+		{
+			UE_LOG(LogSubmarine, Display, TEXT("Perf test %s: %.3f"), *Key, Value.Value)
+			continue;
+		}
+		// Anything under the baseline is fine. Over it has to stay within tolerance.
+		const bool bRegressed = Value.Value > BaselineValue * (1.0 + Tolerance);
+		UE_LOG(LogSubmarine, Display, TEXT("Perf test %s: %.3f (baseline %.3f)%s"), *Key, Value.Value, BaselineValue,
+			bRegressed ? TEXT(" REGRESSED") : TEXT(""))
+		bPassed &= !bRegressed;
+	}
+	return bPassed;
+}
+
+void USubmarinePerfTestSubsystem::Finish()
+{
+	bIsRunning = false;
+	UnbindDelegates();
+	TerminateClients();
+
+	FString Baseline;
+	const bool bHasBaseline = !bUpdateBaseline && FFileHelper::LoadFileToString(Baseline, *BaselinePath);
+	if (!bHasBaseline && !bUpdateBaseline)
+	{
+		UE_LOG(LogSubmarine, Warning, TEXT("Perf test has no baseline at %s; nothing to compare against"), *BaselinePath)
+	}
+	// Net tick is mostly replication to connections, so it only compares with the same number of them
+	int32 BaselineClients = 0;
+	FParse::Value(*Baseline, TEXT("Clients="), BaselineClients);
+	const bool bCompareNetTick = NumClients > 0 && BaselineClients == NumClients;
+	if (bHasBaseline && !bCompareNetTick)
+	{
+		UE_LOG(LogSubmarine, Warning,
+			TEXT("Perf test ran with %d clients and the baseline with %d, not comparing net tick"), NumClients,
+			BaselineClients)
+	}
+
+	const int32 NumFrames = FrameTimeSamples.Num();
+	FString Results = FString::Printf(TEXT("Bots=%d") LINE_TERMINATOR TEXT("Clients=%d") LINE_TERMINATOR
+		TEXT("Frames=%d") LINE_TERMINATOR, Bots.Num(), NumClients, NumFrames);
+	bool bPassed = NumFrames > 0;
+	bPassed &= ReportMetric(TEXT("FrameMs"), FrameTimeSamples, Baseline, Results);
+	bPassed &= ReportMetric(TEXT("NetTickMs"), NetTickSamples, bCompareNetTick ? Baseline : FString(), Results);
+	bPassed &= ReportMetric(TEXT("Actors"), ActorCountSamples, Baseline, Results);
+
+	const FString ResultsPath = FPaths::ProfilingDir() / TEXT("SubmarinePerfTest.txt");
+	FFileHelper::SaveStringToFile(Results, *ResultsPath);
+	if (bUpdateBaseline)
+	{
+		FFileHelper::SaveStringToFile(Results, *BaselinePath);
+		UE_LOG(LogSubmarine, Display, TEXT("Perf test wrote a new baseline to %s"), *BaselinePath)
+	}
+
+	if (bPassed)
+	{
+		UE_LOG(LogSubmarine, Display, TEXT("Perf test passed over %d frames. Results in %s"), NumFrames, *ResultsPath)
+	}
+	else
+	{
+		UE_LOG(LogSubmarine, Error, TEXT("Perf test failed over %d frames. Results in %s"), NumFrames, *ResultsPath)
+	}
+	FPlatformMisc::RequestExitWithStatus(false, bPassed ? 0 : 1);
+}
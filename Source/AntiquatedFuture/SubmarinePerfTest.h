@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformProcess.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SubmarinePerfTest.generated.h"
+
+class ASubmarinePawn;
+
+/**
+ * Headless server load test. Only exists with -SubmarinePerfTest, e.g.
+ *
+ *   AntiquatedFutureServer /Game/GameJam/Maps/ArenaMap -nullrhi -unattended -nosteam -SubmarinePerfTest
+ *     -SubmarinePerfBots=32 -SubmarinePerfClients=8 -SubmarinePerfClientExe=<path to a client build>
+ *
+ * Spawns -SubmarinePerfBots=<count> AI submarines that wander, dash and hold fire through their weapons, and launches
+ * -SubmarinePerfClients=<count> headless client processes (-nullrhi, -SubmarinePerfClient) that connect over
+ * loopback and drive their own submarine the same way, so movement and weapon RPCs and replication to real
+ * connections are part of the load. An uncooked editor binary launches copies of itself when no client executable is
+ * given. Once every client has a submarine (or -SubmarinePerfConnectTimeout=<seconds> fails the run) it waits
+ * -SubmarinePerfWarmup=<seconds>, then samples server frame time, net tick time and actor count every frame for
+ * -SubmarinePerfDuration=<seconds>. p50/p95/p99 go to the log and Saved/Profiling/SubmarinePerfTest.txt.
+ *
+ * The results are checked against -SubmarinePerfBaseline=<file> (Build/SubmarinePerfBaseline.txt by default) and the
+ * process exits with 1 when any percentile is more than -SubmarinePerfTolerance=<fraction> worse. Net tick is only
+ * compared when the run and the baseline had the same number of clients; without any it's barely measuring anything.
+ * Pass -SubmarinePerfUpdateBaseline to write the results as the new baseline instead.
+ */
+UCLASS()
+class ANTIQUATEDFUTURE_API USubmarinePerfTestSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+	struct FBot
+	{
+		TWeakObjectPtr<ASubmarinePawn> Pawn;
+		FVector MoveInput = FVector::ZeroVector;
+		FVector RotateInput = FVector::ZeroVector;
+		double NextSteerTime = 0.0;
+		double NextDashTime = 0.0;
+		double NextFireToggleTime = 0.0;
+		bool bIsFiring = false;
+	};
+
+	struct FPercentiles
+	{
+		double P50 = 0.0;
+		double P95 = 0.0;
+		double P99 = 0.0;
+	};
+
+	int32 NumBots = 32;
+	int32 NumClients = 8;
+	float ClientConnectTimeout = 60.f;
+	float WarmupSeconds = 5.f;
+	float DurationSeconds = 60.f;
+	float Tolerance = 0.1f;
+	FString BaselinePath;
+	bool bUpdateBaseline = false;
+
+	bool bIsRunning = false;
+	// Client: a scripted player for a perf test Server, driving its own Pawn as the only bot
+	bool bIsClient = false;
+	// Server: when the clients were launched, and when measuring started (once they all got in, -1 until then)
+	double ConnectStartTime = 0.0;
+	double StartTime = -1.0;
+	FRandomStream Random;
+	TArray<FBot> Bots;
+	TArray<FProcHandle> ClientProcesses;
+
+	// Timestamps within the current frame. Net time is what the driver spends receiving before Actors tick plus
+	// replicating after they're done.
+	double FrameStartTime = 0.0;
+	double PreActorTickTime = 0.0;
+	double PostActorTickTime = 0.0;
+	double NetTickMs = 0.0;
+	TArray<double> FrameTimeSamples;
+	TArray<double> NetTickSamples;
+	TArray<double> ActorCountSamples;
+
+	FDelegateHandle TickStartHandle;
+	FDelegateHandle PreActorTickHandle;
+	FDelegateHandle PostActorTickHandle;
+	FDelegateHandle PostTickFlushHandle;
+	FDelegateHandle EndFrameHandle;
+
+	void SpawnBots(UWorld& InWorld);
+	void LaunchClients(const UWorld& InWorld);
+	void TerminateClients();
+	// Client connections that have been given a submarine
+	int32 GetNumConnectedClients() const;
+	void DriveBot(FBot& Bot, const double Now);
+	void DriveLocalPawn(const double Now);
+	void OnWorldTickStart(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+	void OnWorldPreActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+	void OnWorldPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+	void OnPostTickFlush();
+	void OnEndFrame();
+	void Finish();
+	void UnbindDelegates();
+
+	static FPercentiles ComputePercentiles(TArray<double>& Samples);
+	// Appends "<Name>.p50=..." style lines. Returns false if any of them regressed against the baseline.
+	bool ReportMetric(const TCHAR* Name, TArray<double>& Samples, const FString& Baseline, FString& OutResults) const;
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+};
@@ -1,7 +1,38 @@
 #include "SubmarinePlayerController.h"
+#include "AntiquatedFuture.h"
 #include "InputAction.h"
 #include "InputMappingContext.h"
 #include "InputModifiers.h"
+#include "SubmarineProxyMovementSubsystem.h"
+
+namespace
+{
+	FAutoConsoleCommandWithWorld RpcBudgetDumpCommand(
+		TEXT("Submarine.RpcBudget"),
+		TEXT("Logs how many Server RPCs each connection made, how many went over budget, and how many movement updates "
+			"were coalesced into a newer one"),
+		FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+		{
+			if (World == nullptr)
+			{
+				return;
+			}
+			for (auto It = World->GetPlayerControllerIterator(); It; ++It)
+			{
+				if (const auto Controller = Cast<ASubmarinePlayerController>(It->Get()))
+				{
+					UE_LOG(LogSubmarineNet, Log, TEXT("%s: %d Server RPCs, %d dropped (budget %.0f/s, %.2f s burst)"),
+						*Controller->GetName(), Controller->NumServerRpcsReceived, Controller->NumServerRpcsDropped,
+						Controller->MaxServerRpcsPerSecond, Controller->ServerRpcBurstSeconds)
+				}
+			}
+			if (const auto ProxyMovement = World->GetSubsystem<USubmarineProxyMovementSubsystem>())
+			{
+				UE_LOG(LogSubmarineNet, Log, TEXT("%d movement updates coalesced into a newer one in the same frame"),
+					ProxyMovement->NumCoalescedMovementUpdates)
+			}
+		}));
+}
 
 ASubmarinePlayerController::ASubmarinePlayerController()
 {
@@ -15,6 +46,38 @@ ASubmarinePlayerController::ASubmarinePlayerController()
 
 	DashAction = CreateDefaultSubobject<UInputAction>(TEXT("Dash Action"));
 	DashAction->ValueType = EInputActionValueType::Boolean;
+
+	// Movement goes up once per Client frame, so this has to clear 240 Hz monitors with room to spare
+	MaxServerRpcsPerSecond = 500.f;
+	ServerRpcBurstSeconds = 0.5f;
+	ServerRpcBudget = -1.0;
+	LastServerRpcBudgetTime = 0.0;
+	NumServerRpcsReceived = 0;
+	NumServerRpcsDropped = 0;
+}
+
+bool ASubmarinePlayerController::ConsumeServerRpcBudget(const bool bIsDroppable)
+{
+	const double MaxBudget = MaxServerRpcsPerSecond * ServerRpcBurstSeconds;
+	const double CurrentTime = GetWorld()->GetRealTimeSeconds();
+	// Everyone starts with a full allowance
+	ServerRpcBudget = ServerRpcBudget < 0.0
+		? MaxBudget
+		: FMath::Min(ServerRpcBudget + (CurrentTime - LastServerRpcBudgetTime) * MaxServerRpcsPerSecond, MaxBudget);
+	LastServerRpcBudgetTime = CurrentTime;
+	++NumServerRpcsReceived;
+
+	if (ServerRpcBudget >= 1.0 || !bIsDroppable)
+	{
+		ServerRpcBudget -= 1.0;
+		return true;
+	}
+	++NumServerRpcsDropped;
+	// A Client hovering right at the limit drops every other packet, so don't log each one
+	SUBMARINE_LOG_RATE_LIMITED(5.0, LogSubmarineNet, Warning,
+		TEXT("%s is over its RPC budget of %.0f/s, dropping movement (%d of %d dropped so far)"),
+		*GetName(), MaxServerRpcsPerSecond, NumServerRpcsDropped, NumServerRpcsReceived);
+	return false;
 }
 
 
@@ -45,7 +108,7 @@ void ASubmarinePlayerController::SetupInputComponent()
 	if (PawnMappingContext == nullptr)
 	{
 		// This is likely to happen when hot reload breaks our Blueprint class
-		UE_LOG(LogTemp, Warning, TEXT("Attempting to set up Input without first constructing the mapping context! "
+		UE_LOG(LogSubmarine, Warning, TEXT("Attempting to set up Input without first constructing the mapping context! "
 								"Constructing it now."))
 		PawnMappingContext = NewObject<UInputMappingContext>(this);
 		
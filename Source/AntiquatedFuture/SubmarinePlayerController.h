@@ -7,16 +7,34 @@
 
 class UInputAction;
 
-UCLASS()
+UCLASS(Config=Game)
 class ANTIQUATEDFUTURE_API ASubmarinePlayerController : public APlayerController
 {
 	GENERATED_BODY()
 
+	// Server: what's left of this connection's RPC allowance, refilled continuously at MaxServerRpcsPerSecond
+	double ServerRpcBudget;
+	double LastServerRpcBudgetTime;
+
 public:
 	ASubmarinePlayerController();
 	
 	virtual void SetupInputComponent() override;
 
+	// Server RPCs a connection may make per second. Movement over the budget is dropped (the next packet repeats it
+	// anyway); reliable RPCs are only counted, since dropping those would desync the Client.
+	UPROPERTY(Config, EditAnywhere)
+	float MaxServerRpcsPerSecond;
+	// How far ahead of the average rate a connection may burst, in seconds' worth of RPCs
+	UPROPERTY(Config, EditAnywhere)
+	float ServerRpcBurstSeconds;
+	// Logged per connection by Submarine.RpcBudget, to tune the two above against
+	int32 NumServerRpcsReceived;
+	int32 NumServerRpcsDropped;
+
+	// Called at the top of every Server RPC from this connection. Returns false if a droppable RPC should be ignored.
+	bool ConsumeServerRpcBudget(const bool bIsDroppable = true);
+
 	UPROPERTY(VisibleDefaultsOnly, BlueprintReadOnly)
 	class UInputMappingContext* PawnMappingContext;
 
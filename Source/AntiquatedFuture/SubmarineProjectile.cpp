@@ -2,22 +2,28 @@
 
 
 #include "SubmarineProjectile.h"
+#include "AntiquatedFuture.h"
 
 #include "NiagaraComponent.h"
+#include "SubmarineHitSubsystem.h"
 #include "Components/SphereComponent.h"
 #include "GameFramework/ProjectileMovementComponent.h"
 
 // Sets default values
 ASubmarineProjectile::ASubmarineProjectile()
 {
+	LLM_SCOPE_BYTAG(Submarine_Projectile);
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
-	bReplicates = true;
-	AActor::SetReplicateMovement(true);
+	// Projectiles are Server-only - Clients draw cosmetic tracers from fire events and play hits from the hit stream
+	bReplicates = false;
+	AActor::SetReplicateMovement(false);
 	
 	Mesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Projectile Mesh"));
 	Mesh->SetupAttachment(RootComponent);
 	SetRootComponent(Mesh);
+	// Movement sweeps the root, so this is where blocking hits actually get reported
+	Mesh->OnComponentHit.AddDynamic(this, &ASubmarineProjectile::OnCollision);
 
 	Collider = CreateDefaultSubobject<USphereComponent>(TEXT("Collider"));
 	Collider->SetSphereRadius(0.05);
@@ -34,13 +40,21 @@ ASubmarineProjectile::ASubmarineProjectile()
 	Movement->InitialSpeed = 1000.f;
 	Movement->MaxSpeed = Movement->InitialSpeed * 10.f;
 	Movement->ProjectileGravityScale = 0.05f;
+
+	bHasHit = false;
 }
 
 // Called when the game starts or when spawned
 void ASubmarineProjectile::BeginPlay()
 {
+	LLM_SCOPE_BYTAG(Submarine_Projectile);
 	Super::BeginPlay();
 	//Movement->SetInterpolatedComponent(Mesh);
+	if (GetInstigator())
+	{
+		// Don't let projectiles hit the submarine that just fired them
+		Mesh->IgnoreActorWhenMoving(GetInstigator(), true);
+	}
 }
 
 // Called every frame
@@ -49,10 +63,28 @@ void ASubmarineProjectile::Tick(float DeltaTime)
 	Super::Tick(DeltaTime);
 }
 
+UNiagaraSystem* ASubmarineProjectile::GetInFlightParticleSystem() const
+{
+	return InFlightParticles ? InFlightParticles->GetAsset() : nullptr;
+}
+
+UNiagaraSystem* ASubmarineProjectile::GetHitParticleSystem() const
+{
+	return HitParticles ? HitParticles->GetAsset() : nullptr;
+}
+
 void ASubmarineProjectile::OnCollision(UPrimitiveComponent* HitComponentSelf, AActor* OtherActor,
 	UPrimitiveComponent* HitComponentOther, FVector NormalImpulse, const FHitResult& HIt)
 {
-	
+	if (bHasHit)
+	{
+		return;
+	}
+	bHasHit = true;
+	if (const auto HitSubsystem = GetWorld()->GetSubsystem<USubmarineHitSubsystem>())
+	{
+		HitSubsystem->QueueHit(this, OtherActor, HIt);
+	}
 }
 
 
@@ -7,6 +7,7 @@
 #include "SubmarineProjectile.generated.h"
 
 class UNiagaraComponent;
+class UNiagaraSystem;
 
 UCLASS(Abstract)
 class ANTIQUATEDFUTURE_API ASubmarineProjectile : public AActor
@@ -44,10 +45,17 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly)
 	float BaseDamage;
 
+	bool bHasHit;
+
 public:	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
+	float GetBaseDamage() const { return BaseDamage; }
+	UStaticMeshComponent* GetMesh() const { return Mesh; }
+	UNiagaraSystem* GetInFlightParticleSystem() const;
+	UNiagaraSystem* GetHitParticleSystem() const;
+
 	UPROPERTY(EditAnywhere, BlueprintReadOnly)
 	class UProjectileMovementComponent* Movement;
 };
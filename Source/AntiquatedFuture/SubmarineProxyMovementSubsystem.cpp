@@ -0,0 +1,188 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SubmarineProxyMovementSubsystem.h"
+#include "AntiquatedFuture.h"
+#include "SubmarineNetQuality.h"
+#include "SubmarinePawn.h"
+#include "Async/ParallelFor.h"
+#include "GameFramework/GameStateBase.h"
+
+bool USubmarineProxyMovementSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId USubmarineProxyMovementSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USubmarineProxyMovementSubsystem, STATGROUP_Tickables);
+}
+
+float USubmarineProxyMovementSubsystem::Now() const
+{
+	const auto GameState = GetWorld()->GetGameState();
+	return GameState ? GameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+}
+
+void USubmarineProxyMovementSubsystem::Register(ASubmarinePawn* Pawn)
+{
+	LLM_SCOPE_BYTAG(Submarine_Pawn);
+	if (Pawn == nullptr || Pawn->ProxyMovementIndex != INDEX_NONE)
+	{
+		return;
+	}
+	Pawn->ProxyMovementIndex = Pawns.Add(Pawn);
+	States.Add(FRepFloatingMovement());
+	HasState.Add(false);
+	HasReceivedState.Add(false);
+	UpdateIntervals.Add(0.f);
+	TimeUntilUpdate.Add(0.f);
+}
+
+void USubmarineProxyMovementSubsystem::Unregister(ASubmarinePawn* Pawn)
+{
+	if (Pawn == nullptr || !Pawns.IsValidIndex(Pawn->ProxyMovementIndex))
+	{
+		return;
+	}
+	const int32 Index = Pawn->ProxyMovementIndex;
+	Pawns.RemoveAtSwap(Index);
+	States.RemoveAtSwap(Index);
+	HasState.RemoveAtSwap(Index);
+	HasReceivedState.RemoveAtSwap(Index);
+	UpdateIntervals.RemoveAtSwap(Index);
+	TimeUntilUpdate.RemoveAtSwap(Index);
+	Pawn->ProxyMovementIndex = INDEX_NONE;
+	// The last proxy was moved into the hole, so it needs to know where it lives now
+	if (Pawns.IsValidIndex(Index) && Pawns[Index].IsValid())
+	{
+		Pawns[Index]->ProxyMovementIndex = Index;
+	}
+}
+
+void USubmarineProxyMovementSubsystem::SetState(const ASubmarinePawn* Pawn, const FRepFloatingMovement& State)
+{
+	if (Pawn && States.IsValidIndex(Pawn->ProxyMovementIndex))
+	{
+		RecordStaleTime(Pawn, Pawn->ProxyMovementIndex);
+		States[Pawn->ProxyMovementIndex] = State;
+		HasState[Pawn->ProxyMovementIndex] = true;
+	}
+}
+
+void USubmarineProxyMovementSubsystem::SetReceivedState(const ASubmarinePawn* Pawn, const FRepFloatingMovement& State)
+{
+	if (Pawn == nullptr || !States.IsValidIndex(Pawn->ProxyMovementIndex))
+	{
+		return;
+	}
+	const int32 Index = Pawn->ProxyMovementIndex;
+	if (HasReceivedState[Index])
+	{
+		++NumCoalescedMovementUpdates;
+	}
+	RecordStaleTime(Pawn, Index);
+	States[Index] = State;
+	HasState[Index] = true;
+	HasReceivedState[Index] = true;
+	// Extrapolate from the new state starting next frame
+	TimeUntilUpdate[Index] = 0.f;
+}
+
+void USubmarineProxyMovementSubsystem::RecordStaleTime(const ASubmarinePawn* Pawn, const int32 Index) const
+{
+	if (!HasState[Index] || !USubmarineNetQualitySubsystem::IsEnabled())
+	{
+		return;
+	}
+	const FRepFloatingMovement& State = States[Index];
+	// A parked sub only replicates at IdleNetUpdateFrequency, so a gap that long is expected rather than stale
+	const bool bWasParked = State.Velocity.SizeSquared() <= FMath::Square(Pawn->IdleSpeedThreshold);
+	const float ExpectedGap = bWasParked && Pawn->IdleNetUpdateFrequency > 0.f
+		? 1.f / Pawn->IdleNetUpdateFrequency
+		: 0.f;
+	// Tick stopped moving the proxy once the old state got this old, and nothing moved it until now
+	const float StaleTime = Now() - (State.Timestamp + FMath::Max(ASubmarinePawn::ExtrapolationLimit, ExpectedGap));
+	if (StaleTime > 0.f)
+	{
+		if (const auto NetQuality = GetWorld()->GetSubsystem<USubmarineNetQualitySubsystem>())
+		{
+			NetQuality->Record(Pawn, ESubmarineNetQualityMetric::Stale, StaleTime * 1000.f);
+		}
+	}
+}
+
+void USubmarineProxyMovementSubsystem::SetUpdateInterval(const ASubmarinePawn* Pawn, const float UpdateInterval)
+{
+	if (Pawn && UpdateIntervals.IsValidIndex(Pawn->ProxyMovementIndex))
+	{
+		UpdateIntervals[Pawn->ProxyMovementIndex] = UpdateInterval;
+	}
+}
+
+void USubmarineProxyMovementSubsystem::Tick(float DeltaTime)
+{
+	const int32 NumProxies = Pawns.Num();
+	if (NumProxies == 0)
+	{
+		return;
+	}
+	const float CurrentTime = Now();
+	ExtrapolatedPositions.SetNumUninitialized(NumProxies, false);
+	ShouldApply.SetNumUninitialized(NumProxies, false);
+
+	// Pure math over the contiguous state arrays - doesn't touch any UObjects so it's safe to go wide
+	ParallelFor(NumProxies, [this, CurrentTime, DeltaTime](const int32 i)
+	{
+		ShouldApply[i] = false;
+		if (!HasState[i])
+		{
+			return;
+		}
+		TimeUntilUpdate[i] -= DeltaTime;
+		if (TimeUntilUpdate[i] > 0.f)
+		{
+			return;
+		}
+		TimeUntilUpdate[i] = UpdateIntervals[i];
+
+		const auto& State = States[i];
+		float ServerDeltaTime = CurrentTime - State.Timestamp;
+		if (ServerDeltaTime >= ASubmarinePawn::ExtrapolationLimit)
+		{
+			// Do nothing while we wait for a fresh movement update. How long that took is recorded when it arrives.
+			return;
+		}
+		if (ServerDeltaTime < 0)
+		{
+			ServerDeltaTime = 0;
+		}
+		ExtrapolatedPositions[i] = State.Position + State.Velocity * ServerDeltaTime;
+		ShouldApply[i] = true;
+	}, NumProxies < MinProxiesForParallelExtrapolation);
+
+	for (int32 i = 0; i < NumProxies; ++i)
+	{
+		// Fresh Client movement goes in exactly as sent, instead of whatever extrapolation came up with
+		if (HasReceivedState[i])
+		{
+			HasReceivedState[i] = false;
+			if (ASubmarinePawn* Pawn = Pawns[i].Get())
+			{
+				Pawn->ApplyReceivedMovement(States[i]);
+			}
+			continue;
+		}
+		if (!ShouldApply[i])
+		{
+			continue;
+		}
+		ASubmarinePawn* Pawn = Pawns[i].Get();
+		// Possession can change after registration (e.g. the Server's own Pawn), so check every time
+		if (Pawn == nullptr || Pawn->IsLocallyControlled())
+		{
+			continue;
+		}
+		Pawn->ApplyExtrapolatedMovement(ExtrapolatedPositions[i], States[i]);
+	}
+}
@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RepFloatingMovement.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SubmarineProxyMovementSubsystem.generated.h"
+
+class ASubmarinePawn;
+
+/**
+ * Extrapolates and applies every remotely controlled submarine in one batch per frame, instead of each one doing
+ * its own Tick -> ApplyLastUpdate. Replicated states are kept in contiguous arrays indexed by
+ * ASubmarinePawn::ProxyMovementIndex.
+ *
+ * On the Server it also applies movement received from Clients: RPCs only buffer their state here, and however many
+ * arrive in a frame, only the newest gets applied (and replicated) once per Pawn per tick.
+ */
+UCLASS()
+class ANTIQUATEDFUTURE_API USubmarineProxyMovementSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	// Below this many proxies it's cheaper to stay on the game thread than to dispatch tasks
+	const int32 MinProxiesForParallelExtrapolation = 32;
+
+protected:
+	TArray<TWeakObjectPtr<ASubmarinePawn>> Pawns;
+	TArray<FRepFloatingMovement> States;
+	TArray<bool> HasState;
+	// Server: a state from the owning Client that hasn't been applied yet
+	TArray<bool> HasReceivedState;
+	// Set by the significance manager for proxies we can barely see
+	TArray<float> UpdateIntervals;
+	TArray<float> TimeUntilUpdate;
+
+	// Per-frame results
+	TArray<FVector> ExtrapolatedPositions;
+	TArray<bool> ShouldApply;
+
+	float Now() const;
+	// Reports how long the proxy sat frozen past ExtrapolationLimit, now that a fresh state has ended it
+	void RecordStaleTime(const ASubmarinePawn* Pawn, const int32 Index) const;
+
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	void Register(ASubmarinePawn* Pawn);
+	void Unregister(ASubmarinePawn* Pawn);
+	void SetState(const ASubmarinePawn* Pawn, const FRepFloatingMovement& State);
+	void SetUpdateInterval(const ASubmarinePawn* Pawn, const float UpdateInterval);
+	// Server: buffers a state received from the Pawn's Client, replacing any that hasn't been applied yet
+	void SetReceivedState(const ASubmarinePawn* Pawn, const FRepFloatingMovement& State);
+
+	// Server: movement RPCs that never got applied because a newer one arrived in the same frame. Logged by
+	// Submarine.RpcBudget.
+	int32 NumCoalescedMovementUpdates = 0;
+};
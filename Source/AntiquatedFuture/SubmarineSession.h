@@ -20,4 +20,24 @@ struct ANTIQUATEDFUTURE_API FSubmarineSession
 	FString Name = "Unknown";
 	UPROPERTY(BlueprintReadOnly)
 	int NumPlayers = -1;
+	UPROPERTY(BlueprintReadOnly)
+	int MaxPlayers = -1;
+	// Round trip to the host in milliseconds, or -1 if we haven't been able to measure it (yet)
+	UPROPERTY(BlueprintReadOnly)
+	int PingMs = -1;
+	// False for test mode's made up sessions, which only exist to fill the list
+	UPROPERTY(BlueprintReadOnly)
+	bool bIsJoinable = true;
+
+	bool IsFull() const { return MaxPlayers > 0 && NumPlayers >= MaxPlayers; }
+	bool CanJoin() const { return bIsJoinable && !IsFull(); }
+};
+
+UENUM(BlueprintType)
+enum class ESubmarineSessionSort : uint8
+{
+	None,
+	Name,
+	NumPlayers,
+	Ping
 };
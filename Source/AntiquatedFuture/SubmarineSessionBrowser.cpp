@@ -0,0 +1,366 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SubmarineSessionBrowser.h"
+#include "AntiquatedFuture.h"
+#include "Icmp.h"
+#include "SubmarineTestOnline.h"
+#include "Interfaces/IPv4/IPv4Address.h"
+
+void USubmarineSessionBrowser::Reset()
+{
+	Entries.Empty();
+	FreeSlots.Empty();
+	SlotsBySessionId.Empty();
+	// NextListIndex carries on, so indices from before the reset can't match anything after it
+	SlotsByListIndex.Empty();
+	View.Empty();
+	bIsViewDirty = true;
+	// Anything still in flight will find its session gone when it completes
+	PendingPingProbes.Empty();
+}
+
+void USubmarineSessionBrowser::ParsePlayerCounts(const FOnlineSessionSearchResult& SearchResult,
+	FSubmarineSession& OutSession) const
+{
+	const auto& Session = SearchResult.Session;
+	OutSession.MaxPlayers = Session.SessionSettings.NumPublicConnections;
+	int32 AdvertisedPlayers = 0;
+	if (!NumPlayersKey.IsNone() && Session.SessionSettings.Get(NumPlayersKey, AdvertisedPlayers))
+	{
+		OutSession.NumPlayers = AdvertisedPlayers;
+	}
+	else
+	{
+		OutSession.NumPlayers = Session.SessionSettings.NumPublicConnections - Session.NumOpenPublicConnections;
+	}
+}
+
+void USubmarineSessionBrowser::UpdateFromSearch(const TArray<FOnlineSessionSearchResult>& SearchResults,
+	const FName& LobbyNameKey)
+{
+	LLM_SCOPE_BYTAG(Submarine_Online);
+	for (auto& Entry: Entries)
+	{
+		Entry.bWasSeen = false;
+	}
+
+	for (const auto& SearchResult: SearchResults)
+	{
+		if (!SearchResult.IsValid() || !IsCompatible(SearchResult))
+		{
+			continue;
+		}
+		const FString SessionId = SearchResult.GetSessionIdStr();
+		if (const int32* ExistingSlot = SlotsBySessionId.Find(SessionId))
+		{
+			// Already parsed - only the things that change while a session is up need refreshing
+			FBrowserEntry& Entry = Entries[*ExistingSlot];
+			Entry.SearchResult = SearchResult;
+			Entry.bWasSeen = true;
+			ParsePlayerCounts(SearchResult, Entry.Session);
+			continue;
+		}
+
+		const int32 Slot = FreeSlots.Num() > 0 ? FreeSlots.Pop(false) : Entries.AddDefaulted();
+		FBrowserEntry& Entry = Entries[Slot];
+		Entry.SessionId = SessionId;
+		Entry.SearchResult = SearchResult;
+		Entry.bIsValid = true;
+		Entry.bWasSeen = true;
+		Entry.Session = FSubmarineSession();
+		Entry.Session.ListIndex = NextListIndex++;
+		Entry.Session.bIsJoinable = !FSubmarineTestOnline::IsSynthetic(SearchResult);
+		if (!SearchResult.Session.SessionSettings.Get(LobbyNameKey, Entry.Session.Name))
+		{
+			UE_LOG(LogSubmarineOnline, Warning, TEXT("Failed to fetch Session name."))
+		}
+		ParsePlayerCounts(SearchResult, Entry.Session);
+		SlotsBySessionId.Add(SessionId, Slot);
+		SlotsByListIndex.Add(Entry.Session.ListIndex, Slot);
+	}
+
+	// Anything we didn't hear about this time has gone away
+	for (int32 Slot = 0; Slot < Entries.Num(); ++Slot)
+	{
+		FBrowserEntry& Entry = Entries[Slot];
+		if (Entry.bIsValid && !Entry.bWasSeen)
+		{
+			SlotsBySessionId.Remove(Entry.SessionId);
+			SlotsByListIndex.Remove(Entry.Session.ListIndex);
+			Entry = FBrowserEntry();
+			FreeSlots.Add(Slot);
+		}
+	}
+	bIsViewDirty = true;
+}
+
+void USubmarineSessionBrowser::SetRequiredBuildVersion(const FName& Key, const int32 BuildVersion)
+{
+	BuildVersionKey = Key;
+	RequiredBuildVersion = BuildVersion;
+}
+
+bool USubmarineSessionBrowser::IsCompatible(const FOnlineSessionSearchResult& SearchResult) const
+{
+	if (BuildVersionKey.IsNone())
+	{
+		return true;
+	}
+	int32 BuildVersion = 0;
+	return SearchResult.Session.SessionSettings.Get(BuildVersionKey, BuildVersion)
+		&& BuildVersion == RequiredBuildVersion;
+}
+
+const USubmarineSessionBrowser::FBrowserEntry* USubmarineSessionBrowser::FindEntry(const int ListIndex) const
+{
+	const int32* Slot = SlotsByListIndex.Find(ListIndex);
+	return Slot ? &Entries[*Slot] : nullptr;
+}
+
+const FOnlineSessionSearchResult* USubmarineSessionBrowser::FindSearchResult(int ListIndex) const
+{
+	const FBrowserEntry* Entry = FindEntry(ListIndex);
+	return Entry ? &Entry->SearchResult : nullptr;
+}
+
+void USubmarineSessionBrowser::SetSort(ESubmarineSessionSort NewSortBy, bool bAscending)
+{
+	if (SortBy != NewSortBy || bSortAscending != bAscending)
+	{
+		SortBy = NewSortBy;
+		bSortAscending = bAscending;
+		bIsViewDirty = true;
+	}
+}
+
+void USubmarineSessionBrowser::SetFilter(const FString& NewNameFilter, bool bHideFull)
+{
+	if (!NameFilter.Equals(NewNameFilter) || bHideFullSessions != bHideFull)
+	{
+		NameFilter = NewNameFilter;
+		bHideFullSessions = bHideFull;
+		bIsViewDirty = true;
+	}
+}
+
+bool USubmarineSessionBrowser::PassesFilter(const FSubmarineSession& Session) const
+{
+	if (bHideFullSessions && Session.IsFull())
+	{
+		return false;
+	}
+	return NameFilter.IsEmpty() || Session.Name.Contains(NameFilter);
+}
+
+void USubmarineSessionBrowser::RebuildViewIfDirty()
+{
+	LLM_SCOPE_BYTAG(Submarine_Online);
+	if (!bIsViewDirty)
+	{
+		return;
+	}
+	bIsViewDirty = false;
+
+	View.Reset();
+	for (int32 Slot = 0; Slot < Entries.Num(); ++Slot)
+	{
+		if (Entries[Slot].bIsValid && PassesFilter(Entries[Slot].Session))
+		{
+			View.Add(Slot);
+		}
+	}
+
+	if (SortBy == ESubmarineSessionSort::None)
+	{
+		return;
+	}
+	View.StableSort([this](const int32 A, const int32 B)
+	{
+		const FSubmarineSession& First = Entries[bSortAscending ? A : B].Session;
+		const FSubmarineSession& Second = Entries[bSortAscending ? B : A].Session;
+		switch (SortBy)
+		{
+			case ESubmarineSessionSort::Name:
+				return First.Name.Compare(Second.Name, ESearchCase::IgnoreCase) < 0;
+			case ESubmarineSessionSort::NumPlayers:
+				return First.NumPlayers < Second.NumPlayers;
+			case ESubmarineSessionSort::Ping:
+				// Unmeasured pings sort last either way
+				if ((First.PingMs < 0) != (Second.PingMs < 0))
+				{
+					return bSortAscending ? Second.PingMs < 0 : First.PingMs < 0;
+				}
+				return First.PingMs < Second.PingMs;
+			default:
+				return false;
+		}
+	});
+}
+
+int USubmarineSessionBrowser::GetNumSessions()
+{
+	RebuildViewIfDirty();
+	return View.Num();
+}
+
+int USubmarineSessionBrowser::GetNumPages(int PageSize)
+{
+	if (PageSize <= 0)
+	{
+		return 0;
+	}
+	return FMath::DivideAndRoundUp(GetNumSessions(), PageSize);
+}
+
+TArray<FSubmarineSession> USubmarineSessionBrowser::GetPage(int PageIndex, int PageSize)
+{
+	RebuildViewIfDirty();
+	TArray<FSubmarineSession> Page;
+	if (PageIndex < 0 || PageSize <= 0)
+	{
+		return Page;
+	}
+	const int32 First = PageIndex * PageSize;
+	const int32 Last = FMath::Min(First + PageSize, View.Num());
+	for (int32 i = First; i < Last; ++i)
+	{
+		Page.Add(Entries[View[i]].Session);
+	}
+	return Page;
+}
+
+TArray<FSubmarineSession> USubmarineSessionBrowser::GetSessions()
+{
+	return GetPage(0, GetNumSessions());
+}
+
+bool USubmarineSessionBrowser::GetSession(int ListIndex, FSubmarineSession& OutSession) const
+{
+	if (const FBrowserEntry* Entry = FindEntry(ListIndex))
+	{
+		OutSession = Entry->Session;
+		return true;
+	}
+	return false;
+}
+
+void USubmarineSessionBrowser::StartPingProbes(const IOnlineSessionPtr& SessionInterface)
+{
+	LLM_SCOPE_BYTAG(Submarine_Online);
+	for (int32 Slot = 0; Slot < Entries.Num(); ++Slot)
+	{
+		FBrowserEntry& Entry = Entries[Slot];
+		if (!Entry.bIsValid || Entry.bHasPingProbe)
+		{
+			continue;
+		}
+		Entry.bHasPingProbe = true;
+
+		// Only IP hosts can be probed directly (Steam P2P addresses can't), so fall back to the backend's estimate
+		FString ConnectString;
+		FString Address;
+		if (SessionInterface.IsValid()
+			&& SessionInterface->GetResolvedConnectString(Entry.SearchResult, NAME_GamePort, ConnectString)
+			&& ConnectString.Split(TEXT(":"), &Address, nullptr, ESearchCase::IgnoreCase, ESearchDir::FromEnd))
+		{
+			FIPv4Address IpAddress;
+			if (FIPv4Address::Parse(Address, IpAddress))
+			{
+				PendingPingProbes.Add({Slot, Entry.SessionId, Address});
+				continue;
+			}
+		}
+		if (Entry.SearchResult.PingInMs >= 0 && Entry.SearchResult.PingInMs < MAX_QUERY_PING)
+		{
+			Entry.Session.PingMs = Entry.SearchResult.PingInMs;
+		}
+	}
+	bIsViewDirty = true;
+	LaunchPingProbes();
+}
+
+void USubmarineSessionBrowser::LaunchPingProbes()
+{
+	while (NumPingProbesInFlight < MaxConcurrentPingProbes && PendingPingProbes.Num() > 0)
+	{
+		const FPingProbe Probe = PendingPingProbes.Pop(false);
+		++NumPingProbesInFlight;
+		TWeakObjectPtr<USubmarineSessionBrowser> WeakThis(this);
+		// Results are delivered on the game thread
+		FIcmp::IcmpEcho(Probe.Address, PingProbeTimeout, [WeakThis, Probe](FIcmpEchoResult Result)
+		{
+			if (WeakThis.IsValid())
+			{
+				WeakThis->OnPingProbeComplete(
+					Probe, Result.Status == EIcmpResponseStatus::Success, Result.Time);
+			}
+		});
+	}
+}
+
+void USubmarineSessionBrowser::OnPingProbeComplete(const FPingProbe& Probe, const bool bSucceeded,
+	const float RoundTripSeconds)
+{
+	--NumPingProbesInFlight;
+	// The slot may have been reused by a different session while we were waiting
+	if (bSucceeded && Entries.IsValidIndex(Probe.Slot) && Entries[Probe.Slot].bIsValid
+		&& Entries[Probe.Slot].SessionId == Probe.SessionId)
+	{
+		Entries[Probe.Slot].Session.PingMs = FMath::RoundToInt(RoundTripSeconds * 1000.f);
+		bIsViewDirty = true;
+	}
+	LaunchPingProbes();
+}
+
+bool USubmarineSessionBrowser::IsBetterJoinCandidate(const FSubmarineSession& Candidate,
+	const FSubmarineSession& Other)
+{
+	const bool bCandidateHasPing = Candidate.PingMs >= 0;
+	const bool bOtherHasPing = Other.PingMs >= 0;
+	if (bCandidateHasPing != bOtherHasPing)
+	{
+		return bCandidateHasPing;
+	}
+	if (Candidate.PingMs != Other.PingMs)
+	{
+		return Candidate.PingMs < Other.PingMs;
+	}
+	return Candidate.NumPlayers > Other.NumPlayers;
+}
+
+int USubmarineSessionBrowser::GetBestSessionIndex() const
+{
+	const FSubmarineSession* Best = nullptr;
+	for (const auto& Entry: Entries)
+	{
+		if (Entry.bIsValid && Entry.Session.CanJoin()
+			&& (Best == nullptr || IsBetterJoinCandidate(Entry.Session, *Best)))
+		{
+			Best = &Entry.Session;
+		}
+	}
+	return Best ? Best->ListIndex : -1;
+}
+
+void USubmarineSessionBrowser::GetJoinCandidates(TArray<int>& OutListIndices) const
+{
+	OutListIndices.Reset();
+	for (const auto& Entry: Entries)
+	{
+		if (Entry.bIsValid && Entry.Session.CanJoin())
+		{
+			OutListIndices.Add(Entry.Session.ListIndex);
+		}
+	}
+	OutListIndices.Sort([this](const int A, const int B)
+	{
+		return IsBetterJoinCandidate(FindEntry(A)->Session, FindEntry(B)->Session);
+	});
+}
+
+FString USubmarineSessionBrowser::GetSessionId(int ListIndex) const
+{
+	const FBrowserEntry* Entry = FindEntry(ListIndex);
+	return Entry ? Entry->SessionId : FString();
+}
@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OnlineSessionSettings.h"
+#include "Interfaces/OnlineSessionInterface.h"
+#include "SubmarineSession.h"
+#include "UObject/Object.h"
+#include "SubmarineSessionBrowser.generated.h"
+
+/**
+ * Persistent model behind the lobby's session list. Each search result is parsed once when it first shows up and
+ * updated in place on later refreshes, so UI can hold on to a session's ListIndex across refreshes.
+ * Sorted/filtered views are only rebuilt when something actually changed.
+ */
+UCLASS(BlueprintType)
+class ANTIQUATEDFUTURE_API USubmarineSessionBrowser : public UObject
+{
+	GENERATED_BODY()
+
+protected:
+	// Probes are cheap but we still don't want to fire thousands of them at once
+	const int32 MaxConcurrentPingProbes = 8;
+	const float PingProbeTimeout = 1.f;
+
+	struct FBrowserEntry
+	{
+		FString SessionId;
+		FOnlineSessionSearchResult SearchResult;
+		FSubmarineSession Session;
+		bool bIsValid = false;
+		bool bWasSeen = false;
+		bool bHasPingProbe = false;
+	};
+
+	// Slots of sessions that disappeared are reused by new ones
+	TArray<FBrowserEntry> Entries;
+	TArray<int32> FreeSlots;
+	TMap<FString, int32> SlotsBySessionId;
+	// A reused slot gets a fresh ListIndex, so UI still holding the old one finds nothing rather than another session
+	TMap<int32, int32> SlotsByListIndex;
+	int32 NextListIndex = 0;
+
+	// Slots that pass the current filter, in the current sort order
+	TArray<int32> View;
+	bool bIsViewDirty = true;
+
+	ESubmarineSessionSort SortBy = ESubmarineSessionSort::None;
+	bool bSortAscending = true;
+	bool bHideFullSessions = false;
+	FString NameFilter;
+
+	// Not every backend honours every query filter, so anything from another build still gets dropped here
+	FName BuildVersionKey;
+	int32 RequiredBuildVersion = 0;
+	// Hosts advertise how many players they actually have, which beats guessing from open connections
+	FName NumPlayersKey;
+
+	struct FPingProbe
+	{
+		int32 Slot;
+		FString SessionId;
+		FString Address;
+	};
+	TArray<FPingProbe> PendingPingProbes;
+	int32 NumPingProbesInFlight = 0;
+
+	void ParsePlayerCounts(const FOnlineSessionSearchResult& SearchResult, FSubmarineSession& OutSession) const;
+	void LaunchPingProbes();
+	void OnPingProbeComplete(const FPingProbe& Probe, const bool bSucceeded, const float RoundTripSeconds);
+	bool PassesFilter(const FSubmarineSession& Session) const;
+	bool IsCompatible(const FOnlineSessionSearchResult& SearchResult) const;
+	static bool IsBetterJoinCandidate(const FSubmarineSession& Candidate, const FSubmarineSession& Other);
+	void RebuildViewIfDirty();
+	const FBrowserEntry* FindEntry(const int ListIndex) const;
+
+public:
+	void UpdateFromSearch(const TArray<FOnlineSessionSearchResult>& SearchResults, const FName& LobbyNameKey);
+	const FOnlineSessionSearchResult* FindSearchResult(int ListIndex) const;
+	void SetRequiredBuildVersion(const FName& Key, const int32 BuildVersion);
+	void SetNumPlayersKey(const FName& Key) { NumPlayersKey = Key; }
+	// Measures latency to every session we haven't pinged yet
+	void StartPingProbes(const IOnlineSessionPtr& SessionInterface);
+
+	// Lowest ping first, then the fullest game. Returns -1 if there's nothing worth joining.
+	UFUNCTION(BlueprintCallable)
+	int GetBestSessionIndex() const;
+	// Every joinable session, best first
+	void GetJoinCandidates(TArray<int>& OutListIndices) const;
+	FString GetSessionId(int ListIndex) const;
+
+	UFUNCTION(BlueprintCallable)
+	void Reset();
+	UFUNCTION(BlueprintCallable)
+	void SetSort(ESubmarineSessionSort NewSortBy, bool bAscending = true);
+	UFUNCTION(BlueprintCallable)
+	void SetFilter(const FString& NewNameFilter, bool bHideFull);
+
+	UFUNCTION(BlueprintCallable)
+	int GetNumSessions();
+	UFUNCTION(BlueprintCallable)
+	int GetNumPages(int PageSize);
+	UFUNCTION(BlueprintCallable)
+	TArray<FSubmarineSession> GetPage(int PageIndex, int PageSize);
+	UFUNCTION(BlueprintCallable)
+	TArray<FSubmarineSession> GetSessions();
+	UFUNCTION(BlueprintCallable)
+	bool GetSession(int ListIndex, FSubmarineSession& OutSession) const;
+};
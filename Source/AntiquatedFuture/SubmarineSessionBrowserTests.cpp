@@ -0,0 +1,357 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AntiquatedFuture.h"
+#include "OnlineSubsystem.h"
+#include "OnlineSubsystemNames.h"
+#include "OnlineSessionSettings.h"
+#include "SubmarineSessionBrowser.h"
+#include "SubmarineTestOnline.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/StrongObjectPtr.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	const FName TestLobbyNameKey = "SubmarineLobbyName";
+	constexpr uint32 SessionTestFlags =
+		EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter;
+
+	FOnlineSessionSearchResult MakeResult(const FString& Id, const FString& Name, const int32 NumPlayers = 1,
+		const int32 MaxPlayers = 8, const int32 PingMs = 50, const bool bIsSynthetic = false)
+	{
+		return FSubmarineTestOnline::MakeSearchResult(Id, Name, TestLobbyNameKey, NumPlayers, MaxPlayers, PingMs,
+			bIsSynthetic);
+	}
+
+	TStrongObjectPtr<USubmarineSessionBrowser> MakeBrowser(const TArray<FOnlineSessionSearchResult>& Results)
+	{
+		TStrongObjectPtr<USubmarineSessionBrowser> Browser(NewObject<USubmarineSessionBrowser>());
+		Browser->UpdateFromSearch(Results, TestLobbyNameKey);
+		// No session interface, so every ping comes from the search result
+		Browser->StartPingProbes(IOnlineSessionPtr());
+		return Browser;
+	}
+
+	// Comma separated, so a failure shows the whole order
+	FString GetNames(const TArray<FSubmarineSession>& Sessions)
+	{
+		TArray<FString> Names;
+		for (const auto& Session: Sessions)
+		{
+			Names.Add(Session.Name);
+		}
+		return FString::Join(Names, TEXT(","));
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSubmarineSessionBrowserStableIndexTest,
+	"AntiquatedFuture.Online.SessionBrowser.StableIndices", SessionTestFlags)
+
+bool FSubmarineSessionBrowserStableIndexTest::RunTest(const FString& Parameters)
+{
+	const auto Browser = MakeBrowser({MakeResult("A", "Alpha"), MakeResult("B", "Bravo"), MakeResult("C", "Charlie")});
+	FSubmarineSession Session;
+	TestTrue(TEXT("Bravo is listed"), Browser->GetSession(1, Session));
+	TestEqual(TEXT("Bravo keeps the slot it was parsed into"), Session.Name, FString("Bravo"));
+
+	// Bravo goes away and Delta shows up, in a different order: everyone else stays put
+	Browser->UpdateFromSearch({MakeResult("C", "Charlie", 3), MakeResult("D", "Delta"), MakeResult("A", "Alpha")},
+		TestLobbyNameKey);
+	TestEqual(TEXT("Sessions after refresh"), Browser->GetNumSessions(), 3);
+	TestTrue(TEXT("Alpha is still listed"), Browser->GetSession(0, Session));
+	TestEqual(TEXT("Alpha index is stable"), Session.Name, FString("Alpha"));
+	TestTrue(TEXT("Charlie is still listed"), Browser->GetSession(2, Session));
+	TestEqual(TEXT("Charlie index is stable"), Session.Name, FString("Charlie"));
+	TestEqual(TEXT("Charlie's player count was refreshed in place"), Session.NumPlayers, 3);
+	TestFalse(TEXT("Bravo's slot is empty"), Browser->GetSession(1, Session));
+	TestTrue(TEXT("Delta is listed"), Browser->GetSession(3, Session));
+	TestEqual(TEXT("Delta knows its own index"), Session.ListIndex, 3);
+
+	// Slots freed by one refresh are handed out on the next, but under a new index
+	Browser->UpdateFromSearch({MakeResult("A", "Alpha"), MakeResult("C", "Charlie"), MakeResult("D", "Delta"),
+		MakeResult("E", "Echo")}, TestLobbyNameKey);
+	TestEqual(TEXT("Sessions after reuse"), Browser->GetNumSessions(), 4);
+	TestFalse(TEXT("Bravo's old index doesn't turn into Echo"), Browser->GetSession(1, Session));
+	TestTrue(TEXT("Echo is listed"), Browser->GetSession(4, Session));
+	TestEqual(TEXT("Echo got a new index"), Session.ListIndex, 4);
+	TestTrue(TEXT("Echo's search result is found by its index"), Browser->FindSearchResult(4) != nullptr
+		&& Browser->FindSearchResult(4)->GetSessionIdStr() == Browser->GetSessionId(4));
+	TestFalse(TEXT("Nothing past the last index"), Browser->GetSession(5, Session));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSubmarineSessionBrowserSortTest,
+	"AntiquatedFuture.Online.SessionBrowser.Sort", SessionTestFlags)
+
+bool FSubmarineSessionBrowserSortTest::RunTest(const FString& Parameters)
+{
+	const auto Browser = MakeBrowser({
+		MakeResult("A", "bravo", 4, 8, 80),
+		MakeResult("B", "Alpha", 2, 8, -1),
+		MakeResult("C", "charlie", 6, 8, 20)});
+
+	Browser->SetSort(ESubmarineSessionSort::Name);
+	TestEqual(TEXT("Name ascending ignores case"), GetNames(Browser->GetSessions()),
+		FString("Alpha,bravo,charlie"));
+	Browser->SetSort(ESubmarineSessionSort::Name, false);
+	TestEqual(TEXT("Name descending"), GetNames(Browser->GetSessions()),
+		FString("charlie,bravo,Alpha"));
+	Browser->SetSort(ESubmarineSessionSort::NumPlayers);
+	TestEqual(TEXT("Players ascending"), GetNames(Browser->GetSessions()),
+		FString("Alpha,bravo,charlie"));
+	Browser->SetSort(ESubmarineSessionSort::Ping);
+	TestEqual(TEXT("Ping ascending, unmeasured last"), GetNames(Browser->GetSessions()),
+		FString("charlie,bravo,Alpha"));
+	Browser->SetSort(ESubmarineSessionSort::Ping, false);
+	TestEqual(TEXT("Ping descending, unmeasured still last"), GetNames(Browser->GetSessions()),
+		FString("bravo,charlie,Alpha"));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSubmarineSessionBrowserFilterTest,
+	"AntiquatedFuture.Online.SessionBrowser.Filter", SessionTestFlags)
+
+bool FSubmarineSessionBrowserFilterTest::RunTest(const FString& Parameters)
+{
+	const auto Browser = MakeBrowser({
+		MakeResult("A", "Deep Dive", 8, 8),
+		MakeResult("B", "Shallow End", 2, 8),
+		MakeResult("C", "Deep End", 3, 8)});
+
+	Browser->SetFilter(TEXT("Deep"), false);
+	TestEqual(TEXT("Name filter"), Browser->GetNumSessions(), 2);
+	Browser->SetFilter(TEXT("Deep"), true);
+	TestEqual(TEXT("Name filter and hide full"), GetNames(Browser->GetSessions()), FString("Deep End"));
+	Browser->SetFilter(FString(), true);
+	TestEqual(TEXT("Hide full only"), Browser->GetNumSessions(), 2);
+	Browser->SetFilter(FString(), false);
+	TestEqual(TEXT("No filter"), Browser->GetNumSessions(), 3);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSubmarineSessionBrowserPagingTest,
+	"AntiquatedFuture.Online.SessionBrowser.Paging", SessionTestFlags)
+
+bool FSubmarineSessionBrowserPagingTest::RunTest(const FString& Parameters)
+{
+	TArray<FOnlineSessionSearchResult> Results;
+	for (int32 i = 0; i < 45; ++i)
+	{
+		Results.Add(MakeResult(FString::Printf(TEXT("Session%d"), i), FString::Printf(TEXT("Lobby %02d"), i)));
+	}
+	const auto Browser = MakeBrowser(Results);
+	Browser->SetSort(ESubmarineSessionSort::Name);
+
+	TestEqual(TEXT("Pages of 20"), Browser->GetNumPages(20), 3);
+	TestEqual(TEXT("Full page"), Browser->GetPage(1, 20).Num(), 20);
+	const TArray<FSubmarineSession> LastPage = Browser->GetPage(2, 20);
+	TestEqual(TEXT("Partial last page"), LastPage.Num(), 5);
+	if (LastPage.Num() > 0)
+	{
+		TestEqual(TEXT("Last page starts where the previous one ended"), LastPage[0].Name, FString("Lobby 40"));
+	}
+	TestEqual(TEXT("Past the end"), Browser->GetPage(3, 20).Num(), 0);
+	TestEqual(TEXT("Negative page"), Browser->GetPage(-1, 20).Num(), 0);
+	TestEqual(TEXT("Zero page size"), Browser->GetNumPages(0), 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSubmarineSessionBrowserJoinCandidatesTest,
+	"AntiquatedFuture.Online.SessionBrowser.JoinCandidates", SessionTestFlags)
+
+bool FSubmarineSessionBrowserJoinCandidatesTest::RunTest(const FString& Parameters)
+{
+	const auto Browser = MakeBrowser({
+		MakeResult("Synthetic", "Synthetic", 1, 8, 5, true),
+		MakeResult("Full", "Full", 8, 8, 10),
+		MakeResult("Far", "Far", 2, 8, 120),
+		MakeResult("Near", "Near", 3, 8, 30),
+		MakeResult("NearEmpty", "Near Empty", 1, 8, 30)});
+
+	FSubmarineSession Synthetic;
+	Browser->GetSession(0, Synthetic);
+	TestFalse(TEXT("Synthetic sessions aren't joinable"), Synthetic.bIsJoinable);
+	TestEqual(TEXT("Synthetic sessions are still listed"), Browser->GetNumSessions(), 5);
+
+	TestEqual(TEXT("Best session is the lowest ping, then the fullest"), Browser->GetBestSessionIndex(), 3);
+	TArray<int> Candidates;
+	Browser->GetJoinCandidates(Candidates);
+	TestEqual(TEXT("Candidates skip synthetic and full sessions, best first"),
+		FString::JoinBy(Candidates, TEXT(","), [](const int Index) { return FString::FromInt(Index); }),
+		FString("3,4,2"));
+	return true;
+}
+
+/**
+ * Hosts a LAN session on one Null subsystem instance, finds it from another, lists it in the browser and joins it -
+ * the same round trip -SubmarineTestOnline runs, minus the Game Instance.
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSubmarineNullSessionRoundTripTest,
+	"AntiquatedFuture.Online.NullCreateFindJoin", SessionTestFlags)
+
+bool FSubmarineNullSessionRoundTripTest::RunTest(const FString& Parameters)
+{
+	const FName HostInstance = "NULL:SubmarineTestHost";
+	const FName ClientInstance = "NULL:SubmarineTestClient";
+	const FName HostSessionName = "SubmarineTestHostSession";
+	const FName JoinSessionName = "SubmarineTestJoinSession";
+	const FString LobbyName = FString::Printf(TEXT("Automation %s"), *FGuid::NewGuid().ToString());
+
+	IOnlineSubsystem* Host = IOnlineSubsystem::Get(HostInstance);
+	IOnlineSubsystem* Client = IOnlineSubsystem::Get(ClientInstance);
+	if (!TestNotNull(TEXT("Null host subsystem"), Host) || !TestNotNull(TEXT("Null client subsystem"), Client))
+	{
+		return false;
+	}
+	const IOnlineSessionPtr HostSessions = Host->GetSessionInterface();
+	const IOnlineSessionPtr ClientSessions = Client->GetSessionInterface();
+	if (!TestTrue(TEXT("Session interfaces"), HostSessions.IsValid() && ClientSessions.IsValid()))
+	{
+		return false;
+	}
+
+	struct FRoundTrip
+	{
+		bool bCreateDone = false;
+		bool bCreated = false;
+		bool bFindDone = false;
+		bool bJoinDone = false;
+		EOnJoinSessionCompleteResult::Type JoinResult = EOnJoinSessionCompleteResult::UnknownError;
+		double Deadline = 0.0;
+		// Each phase is timed from the call to its completion delegate, so latent command ticks don't count
+		double PhaseStartTime = 0.0;
+		double CreateSeconds = 0.0;
+		double FindSeconds = 0.0;
+		double JoinSeconds = 0.0;
+		TSharedRef<FOnlineSessionSearch> Search = MakeShared<FOnlineSessionSearch>();
+		FDelegateHandle CreateHandle;
+		FDelegateHandle FindHandle;
+		FDelegateHandle JoinHandle;
+	};
+	const TSharedRef<FRoundTrip> State = MakeShared<FRoundTrip>();
+	State->Deadline = FPlatformTime::Seconds() + 30.0;
+	const auto TimedOut = [this, State](const TCHAR* Step)
+	{
+		if (FPlatformTime::Seconds() < State->Deadline)
+		{
+			return false;
+		}
+		AddError(FString::Printf(TEXT("Timed out waiting for %s"), Step));
+		return true;
+	};
+
+	FOnlineSessionSettings Settings;
+	Settings.NumPublicConnections = 4;
+	Settings.bIsLANMatch = true;
+	Settings.bShouldAdvertise = true;
+	Settings.bAllowJoinInProgress = true;
+	Settings.Set(TestLobbyNameKey, LobbyName, EOnlineDataAdvertisementType::ViaOnlineService);
+	State->CreateHandle = HostSessions->AddOnCreateSessionCompleteDelegate_Handle(
+		FOnCreateSessionCompleteDelegate::CreateLambda([State](FName, const bool bWasSuccessful)
+		{
+			State->CreateSeconds = FPlatformTime::Seconds() - State->PhaseStartTime;
+			State->bCreateDone = true;
+			State->bCreated = bWasSuccessful;
+		}));
+	State->PhaseStartTime = FPlatformTime::Seconds();
+	HostSessions->CreateSession(0, HostSessionName, Settings);
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, State, HostSessions, ClientSessions, TimedOut]()
+	{
+		if (!State->bCreateDone)
+		{
+			return TimedOut(TEXT("CreateSession"));
+		}
+		HostSessions->ClearOnCreateSessionCompleteDelegate_Handle(State->CreateHandle);
+		AddInfo(FString::Printf(TEXT("CreateSession took %.1f ms"), State->CreateSeconds * 1000.0));
+		if (!TestTrue(TEXT("Created a LAN session"), State->bCreated))
+		{
+			return true;
+		}
+		State->Search->bIsLanQuery = true;
+		State->Search->MaxSearchResults = 50;
+		State->FindHandle = ClientSessions->AddOnFindSessionsCompleteDelegate_Handle(
+			FOnFindSessionsCompleteDelegate::CreateLambda([State](bool)
+			{
+				State->FindSeconds = FPlatformTime::Seconds() - State->PhaseStartTime;
+				State->bFindDone = true;
+			}));
+		State->PhaseStartTime = FPlatformTime::Seconds();
+		ClientSessions->FindSessions(0, State->Search);
+		return true;
+	}));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, State, ClientSessions, JoinSessionName, LobbyName,
+		TimedOut]()
+	{
+		if (State->bCreated && !State->bFindDone)
+		{
+			return TimedOut(TEXT("FindSessions"));
+		}
+		ClientSessions->ClearOnFindSessionsCompleteDelegate_Handle(State->FindHandle);
+		if (!State->bFindDone)
+		{
+			return true;
+		}
+		AddInfo(FString::Printf(TEXT("FindSessions took %.1f ms and found %d sessions"), State->FindSeconds * 1000.0,
+			State->Search->SearchResults.Num()));
+
+		// Other LAN hosts may show up too, so only ours counts
+		TStrongObjectPtr<USubmarineSessionBrowser> Browser(NewObject<USubmarineSessionBrowser>());
+		Browser->UpdateFromSearch(State->Search->SearchResults, TestLobbyNameKey);
+		Browser->SetFilter(LobbyName, false);
+		const TArray<FSubmarineSession> Found = Browser->GetSessions();
+		if (!TestEqual(TEXT("Found our session exactly once"), Found.Num(), 1))
+		{
+			return true;
+		}
+		TestTrue(TEXT("A real session is joinable"), Found[0].CanJoin());
+		TestEqual(TEXT("Max players come from the host's settings"), Found[0].MaxPlayers, 4);
+		const FOnlineSessionSearchResult* SearchResult = Browser->FindSearchResult(Found[0].ListIndex);
+		if (!TestNotNull(TEXT("Browser keeps the search result"), SearchResult))
+		{
+			return true;
+		}
+
+		State->JoinHandle = ClientSessions->AddOnJoinSessionCompleteDelegate_Handle(
+			FOnJoinSessionCompleteDelegate::CreateLambda([State](FName, const EOnJoinSessionCompleteResult::Type Result)
+			{
+				State->JoinSeconds = FPlatformTime::Seconds() - State->PhaseStartTime;
+				State->bJoinDone = true;
+				State->JoinResult = Result;
+			}));
+		State->PhaseStartTime = FPlatformTime::Seconds();
+		ClientSessions->JoinSession(0, JoinSessionName, *SearchResult);
+		return true;
+	}));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, State, HostSessions, ClientSessions, HostInstance,
+		ClientInstance, HostSessionName, JoinSessionName, TimedOut]()
+	{
+		if (State->JoinHandle.IsValid() && !State->bJoinDone && !TimedOut(TEXT("JoinSession")))
+		{
+			return false;
+		}
+		if (State->bJoinDone)
+		{
+			AddInfo(FString::Printf(TEXT("JoinSession took %.1f ms"), State->JoinSeconds * 1000.0));
+			AddInfo(FString::Printf(TEXT("Create, find and join took %.1f ms in total"),
+				(State->CreateSeconds + State->FindSeconds + State->JoinSeconds) * 1000.0));
+			TestTrue(TEXT("Joined the session"), State->JoinResult == EOnJoinSessionCompleteResult::Success);
+			FString ConnectString;
+			TestTrue(TEXT("Joined session resolves to an address"),
+				ClientSessions->GetResolvedConnectString(JoinSessionName, ConnectString));
+		}
+		ClientSessions->ClearOnJoinSessionCompleteDelegate_Handle(State->JoinHandle);
+		ClientSessions->DestroySession(JoinSessionName);
+		HostSessions->DestroySession(HostSessionName);
+		IOnlineSubsystem::Destroy(ClientInstance);
+		IOnlineSubsystem::Destroy(HostInstance);
+		return true;
+	}));
+	return true;
+}
+
+#endif
@@ -0,0 +1,149 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SubmarineSignificanceSubsystem.h"
+#include "AntiquatedFuture.h"
+#include "SubmarinePawn.h"
+#include "SubmarineProxyMovementSubsystem.h"
+#include "SubmarineWeapons.h"
+#include "GameFramework/PlayerController.h"
+
+bool USubmarineSignificanceSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// A dedicated server has no view to be significant to
+	return Super::ShouldCreateSubsystem(Outer) && !IsRunningDedicatedServer();
+}
+
+bool USubmarineSignificanceSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId USubmarineSignificanceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USubmarineSignificanceSubsystem, STATGROUP_Tickables);
+}
+
+float USubmarineSignificanceSubsystem::GetTickInterval(const ESubmarineSignificance Significance)
+{
+	switch (Significance)
+	{
+		case ESubmarineSignificance::Critical:
+		case ESubmarineSignificance::High:
+			// 0 means every frame
+			return 0.f;
+		case ESubmarineSignificance::Medium:
+			return 1.f / 30.f;
+		case ESubmarineSignificance::Low:
+		default:
+			return 1.f / 10.f;
+	}
+}
+
+void USubmarineSignificanceSubsystem::Register(AActor* Actor)
+{
+	LLM_SCOPE_BYTAG(Submarine_Pawn);
+	if (Actor == nullptr)
+	{
+		return;
+	}
+	// Start everything at full rate until the next evaluation tells us otherwise
+	Entries.FindOrAdd(Actor, ESubmarineSignificance::High);
+}
+
+void USubmarineSignificanceSubsystem::Unregister(AActor* Actor)
+{
+	Entries.Remove(Actor);
+}
+
+void USubmarineSignificanceSubsystem::Tick(float DeltaTime)
+{
+	TimeSinceLastEvaluation += DeltaTime;
+	if (TimeSinceLastEvaluation < EvaluationPeriod || Entries.Num() == 0)
+	{
+		return;
+	}
+	TimeSinceLastEvaluation = 0.f;
+
+	// Splitscreen is enabled, so an actor only needs to be significant to one of the local players
+	TArray<FVector> ViewLocations;
+	TArray<FVector> ViewDirections;
+	for (auto It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (PlayerController && PlayerController->IsLocalController())
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			ViewLocations.Add(ViewLocation);
+			ViewDirections.Add(ViewRotation.Vector());
+		}
+	}
+	if (ViewLocations.Num() == 0)
+	{
+		return;
+	}
+
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		AActor* Actor = It->Key.Get();
+		if (Actor == nullptr)
+		{
+			It.RemoveCurrent();
+			continue;
+		}
+		const auto Significance = Evaluate(Actor, ViewLocations, ViewDirections);
+		if (Significance != It->Value)
+		{
+			It->Value = Significance;
+			Apply(Actor, Significance);
+		}
+	}
+}
+
+ESubmarineSignificance USubmarineSignificanceSubsystem::Evaluate(const AActor* Actor,
+	const TArray<FVector>& ViewLocations, const TArray<FVector>& ViewDirections) const
+{
+	const auto SubmarinePawn = Cast<ASubmarinePawn>(Actor);
+	if (SubmarinePawn && SubmarinePawn->bIsJuggernaut)
+	{
+		return ESubmarineSignificance::Critical;
+	}
+
+	auto Significance = ESubmarineSignificance::Low;
+	const FVector ActorLocation = Actor->GetActorLocation();
+	for (int i = 0; i < ViewLocations.Num(); ++i)
+	{
+		const FVector ToActor = ActorLocation - ViewLocations[i];
+		const float DistanceSquared = ToActor.SizeSquared();
+		if (DistanceSquared < FMath::Square(NearDistance))
+		{
+			return ESubmarineSignificance::High;
+		}
+		const bool bIsInView = FVector::DotProduct(ToActor.GetSafeNormal(), ViewDirections[i]) > InViewCosine;
+		if (bIsInView && DistanceSquared < FMath::Square(FarDistance))
+		{
+			Significance = ESubmarineSignificance::Medium;
+		}
+	}
+	return Significance;
+}
+
+void USubmarineSignificanceSubsystem::Apply(AActor* Actor, const ESubmarineSignificance Significance)
+{
+	const float TickInterval = GetTickInterval(Significance);
+	Actor->SetActorTickInterval(TickInterval);
+	if (const auto SubmarinePawn = Cast<ASubmarinePawn>(Actor))
+	{
+		// Proxy submarines don't Tick themselves, their movement is applied in a batch
+		if (const auto ProxyMovement = Actor->GetWorld()->GetSubsystem<USubmarineProxyMovementSubsystem>())
+		{
+			ProxyMovement->SetUpdateInterval(SubmarinePawn, TickInterval);
+		}
+		for (const auto& Weapon: SubmarinePawn->GetWeapons())
+		{
+			Weapon->SetComponentTickInterval(TickInterval);
+		}
+	}
+}
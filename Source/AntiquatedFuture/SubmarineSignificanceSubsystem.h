@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SubmarineSignificanceSubsystem.generated.h"
+
+UENUM(BlueprintType)
+enum class ESubmarineSignificance : uint8
+{
+	// The Juggernaut - always ticks at full rate no matter where it is
+	Critical,
+	// Close enough to the local player that any hitch would be noticeable
+	High,
+	// On screen, but far away
+	Medium,
+	// Off screen or very far away
+	Low
+};
+
+/**
+ * Client-only manager that buckets remote actors (Simulated Proxy submarines and their weapons) by distance and
+ * view, then lowers their Tick rate to match. Nearby and Juggernaut actors stay at full rate.
+ */
+UCLASS()
+class ANTIQUATEDFUTURE_API USubmarineSignificanceSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	// Significance doesn't change quickly, so there's no need to re-bucket every frame
+	const float EvaluationPeriod = 0.25f;
+	const float NearDistance = 3000.f;
+	const float FarDistance = 10000.f;
+	// Cosine of the half-angle we treat as "in view" - wider than the camera FOV so things don't pop at the edges
+	const float InViewCosine = 0.5f;
+
+protected:
+	TMap<TWeakObjectPtr<AActor>, ESubmarineSignificance> Entries;
+	float TimeSinceLastEvaluation;
+
+	ESubmarineSignificance Evaluate(const AActor* Actor, const TArray<FVector>& ViewLocations,
+		const TArray<FVector>& ViewDirections) const;
+	static void Apply(AActor* Actor, const ESubmarineSignificance Significance);
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	static float GetTickInterval(const ESubmarineSignificance Significance);
+
+	// Only actors that are simulated on this client should be registered - we never throttle anything we own
+	void Register(AActor* Actor);
+	void Unregister(AActor* Actor);
+};
@@ -0,0 +1,142 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SubmarineTestOnline.h"
+#include "AntiquatedFuture.h"
+#include "OnlineSubsystemNames.h"
+#include "OnlineSubsystemTypes.h"
+#include "SubmarineSessionBrowser.h"
+
+namespace
+{
+	const FName BenchLobbyNameKey = "SubmarineLobbyName";
+	const FName SyntheticSessionKey = "SubmarineSynthetic";
+
+	// Just enough session info for a search result to count as valid. Never hand one of these to a real backend.
+	class FSubmarineSyntheticSessionInfo : public FOnlineSessionInfo
+	{
+		FUniqueNetIdRef SessionId;
+
+	public:
+		explicit FSubmarineSyntheticSessionInfo(const FString& Id)
+			: SessionId(FUniqueNetIdString::Create(Id, NULL_SUBSYSTEM))
+		{
+		}
+
+		virtual const uint8* GetBytes() const override { return nullptr; }
+		virtual int32 GetSize() const override { return sizeof(FSubmarineSyntheticSessionInfo); }
+		virtual bool IsValid() const override { return true; }
+		virtual FString ToString() const override { return SessionId->ToString(); }
+		virtual FString ToDebugString() const override { return ToString(); }
+		virtual const FUniqueNetId& GetSessionId() const override { return *SessionId; }
+	};
+
+	double MillisecondsSince(const double StartTime)
+	{
+		return (FPlatformTime::Seconds() - StartTime) * 1000.0;
+	}
+
+	void BenchSessionBrowser(const TArray<FString>& Args)
+	{
+		const int32 NumResults = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1000;
+		const int32 Iterations = FMath::Max(1, Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 20);
+
+		FOnlineSessionSettings Template;
+		Template.NumPublicConnections = 12;
+		TArray<FOnlineSessionSearchResult> Results;
+		FSubmarineTestOnline::AddSyntheticSearchResults(Results, NumResults, Template, BenchLobbyNameKey);
+
+		USubmarineSessionBrowser* Browser = NewObject<USubmarineSessionBrowser>();
+		double FirstUpdate = 0.0;
+		double RefreshUpdate = 0.0;
+		double SortedRead = 0.0;
+		double CachedRead = 0.0;
+		double PageRead = 0.0;
+		for (int32 i = 0; i < Iterations; ++i)
+		{
+			Browser->Reset();
+			double StartTime = FPlatformTime::Seconds();
+			Browser->UpdateFromSearch(Results, BenchLobbyNameKey);
+			FirstUpdate += MillisecondsSince(StartTime);
+
+			StartTime = FPlatformTime::Seconds();
+			Browser->UpdateFromSearch(Results, BenchLobbyNameKey);
+			RefreshUpdate += MillisecondsSince(StartTime);
+
+			Browser->SetSort(i % 2 == 0 ? ESubmarineSessionSort::Name : ESubmarineSessionSort::NumPlayers);
+			StartTime = FPlatformTime::Seconds();
+			Browser->GetSessions();
+			SortedRead += MillisecondsSince(StartTime);
+
+			StartTime = FPlatformTime::Seconds();
+			Browser->GetSessions();
+			CachedRead += MillisecondsSince(StartTime);
+
+			StartTime = FPlatformTime::Seconds();
+			Browser->GetPage(0, 20);
+			PageRead += MillisecondsSince(StartTime);
+		}
+		Browser->MarkAsGarbage();
+
+		UE_LOG(LogSubmarineOnline, Display, TEXT("Session browser with %d results, average of %d runs:"), NumResults,
+			Iterations)
+		UE_LOG(LogSubmarineOnline, Display, TEXT("  first UpdateFromSearch: %.3f ms"), FirstUpdate / Iterations)
+		UE_LOG(LogSubmarineOnline, Display, TEXT("  refresh UpdateFromSearch: %.3f ms"), RefreshUpdate / Iterations)
+		UE_LOG(LogSubmarineOnline, Display, TEXT("  GetSearchResults after re-sort: %.3f ms"), SortedRead / Iterations)
+		UE_LOG(LogSubmarineOnline, Display, TEXT("  GetSearchResults cached: %.3f ms"), CachedRead / Iterations)
+		UE_LOG(LogSubmarineOnline, Display, TEXT("  GetPage(0, 20) cached: %.3f ms"), PageRead / Iterations)
+	}
+
+	FAutoConsoleCommand BenchSessionBrowserCommand(
+		TEXT("Submarine.BenchSessionBrowser"),
+		TEXT("Times the lobby list against synthetic search results. Args: [NumResults=1000] [Iterations=20]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchSessionBrowser));
+}
+
+void FSubmarineTestOnline::AddSyntheticSearchResults(TArray<FOnlineSessionSearchResult>& OutResults,
+	const int32 Count, const FOnlineSessionSettings& Template, const FName& LobbyNameKey)
+{
+	const FUniqueNetIdRef OwnerId = FUniqueNetIdString::Create(TEXT("SyntheticHost"), NULL_SUBSYSTEM);
+	OutResults.Reserve(OutResults.Num() + Count);
+	for (int32 i = 0; i < Count; ++i)
+	{
+		FOnlineSessionSearchResult& Result = OutResults.AddDefaulted_GetRef();
+		Result.Session = FOnlineSession(Template);
+		Result.Session.OwningUserId = OwnerId;
+		Result.Session.OwningUserName = TEXT("SyntheticHost");
+		Result.Session.SessionInfo = MakeShared<FSubmarineSyntheticSessionInfo>(
+			FString::Printf(TEXT("SyntheticSession%d"), i));
+		Result.Session.NumOpenPublicConnections = FMath::RandRange(0, Template.NumPublicConnections);
+		Result.Session.SessionSettings.Set(LobbyNameKey, FString::Printf(TEXT("Synthetic Lobby %d"), i),
+			EOnlineDataAdvertisementType::ViaOnlineService);
+		Result.Session.SessionSettings.Set(SyntheticSessionKey, true, EOnlineDataAdvertisementType::DontAdvertise);
+		Result.PingInMs = FMath::RandRange(10, 250);
+	}
+}
+
+FOnlineSessionSearchResult FSubmarineTestOnline::MakeSearchResult(const FString& SessionId, const FString& LobbyName,
+	const FName& LobbyNameKey, const int32 NumPlayers, const int32 MaxPlayers, const int32 PingMs,
+	const bool bIsSynthetic)
+{
+	FOnlineSessionSettings Settings;
+	Settings.NumPublicConnections = MaxPlayers;
+	FOnlineSessionSearchResult Result;
+	Result.Session = FOnlineSession(Settings);
+	Result.Session.OwningUserId = FUniqueNetIdString::Create(TEXT("SyntheticHost"), NULL_SUBSYSTEM);
+	Result.Session.OwningUserName = TEXT("SyntheticHost");
+	Result.Session.SessionInfo = MakeShared<FSubmarineSyntheticSessionInfo>(SessionId);
+	Result.Session.NumOpenPublicConnections = MaxPlayers - NumPlayers;
+	Result.Session.SessionSettings.Set(LobbyNameKey, LobbyName, EOnlineDataAdvertisementType::ViaOnlineService);
+	if (bIsSynthetic)
+	{
+		Result.Session.SessionSettings.Set(SyntheticSessionKey, true, EOnlineDataAdvertisementType::DontAdvertise);
+	}
+	Result.PingInMs = PingMs;
+	return Result;
+}
+
+bool FSubmarineTestOnline::IsSynthetic(const FOnlineSessionSearchResult& SearchResult)
+{
+	bool bIsSynthetic = false;
+	return SearchResult.Session.SessionSettings.Get(SyntheticSessionKey, bIsSynthetic) && bIsSynthetic;
+}
@@ -0,0 +1,29 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OnlineSessionSettings.h"
+
+/**
+ * Helpers for exercising the lobby flow without Steam/EOS. With -SubmarineTestOnline the Game Instance runs on the Null
+ * subsystem, delays every backend call by -SubmarineTestLatency=<seconds> and pads each search with
+ * -SubmarineTestResults=<count> made up sessions. -SubmarineTestNoCachedLogIn makes the persistent log in fail so the
+ * account portal fallback runs.
+ *
+ * Submarine.BenchSessionBrowser [NumResults] [Iterations] measures what the lobby list costs at scale, and the
+ * AntiquatedFuture.Online automation tests check the browser and a create/find/join round trip on the Null subsystem.
+ */
+class ANTIQUATEDFUTURE_API FSubmarineTestOnline
+{
+public:
+	static void AddSyntheticSearchResults(
+		TArray<FOnlineSessionSearchResult>& OutResults, const int32 Count, const FOnlineSessionSettings& Template,
+		const FName& LobbyNameKey);
+	// One made up result with exactly these numbers. Only synthetic ones are kept out of joins.
+	static FOnlineSessionSearchResult MakeSearchResult(const FString& SessionId, const FString& LobbyName,
+		const FName& LobbyNameKey, const int32 NumPlayers, const int32 MaxPlayers, const int32 PingMs,
+		const bool bIsSynthetic = true);
+	// Synthetic results have no host behind them, and the Null subsystem would crash trying to join one
+	static bool IsSynthetic(const FOnlineSessionSearchResult& SearchResult);
+};
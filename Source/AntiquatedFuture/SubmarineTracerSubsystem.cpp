@@ -0,0 +1,148 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SubmarineTracerSubsystem.h"
+#include "AntiquatedFuture.h"
+#include "SubmarineProjectile.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+
+bool USubmarineTracerSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	return Super::ShouldCreateSubsystem(Outer) && !IsRunningDedicatedServer();
+}
+
+bool USubmarineTracerSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId USubmarineTracerSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USubmarineTracerSubsystem, STATGROUP_Tickables);
+}
+
+USubmarineTracerSubsystem::FTracerBatch* USubmarineTracerSubsystem::FindOrCreateBatch(
+	TSubclassOf<ASubmarineProjectile> ProjectileClass)
+{
+	LLM_SCOPE_BYTAG(Submarine_Projectile);
+	if (FTracerBatch* Batch = Batches.Find(ProjectileClass))
+	{
+		return Batch;
+	}
+
+	if (TracerActor == nullptr)
+	{
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.ObjectFlags |= RF_Transient;
+		TracerActor = GetWorld()->SpawnActor<AActor>(SpawnParameters);
+		USceneComponent* Root = NewObject<USceneComponent>(TracerActor);
+		TracerActor->SetRootComponent(Root);
+		Root->RegisterComponent();
+	}
+
+	// Look the same as the real thing by copying the mesh setup from the projectile's defaults
+	const auto ProjectileDefaultObject = ProjectileClass->GetDefaultObject<ASubmarineProjectile>();
+	const UStaticMeshComponent* ProjectileMesh = ProjectileDefaultObject->GetMesh();
+	UInstancedStaticMeshComponent* Instances = NewObject<UInstancedStaticMeshComponent>(TracerActor);
+	Instances->SetMobility(EComponentMobility::Movable);
+	Instances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Instances->SetCastShadow(false);
+	Instances->SetStaticMesh(ProjectileMesh->GetStaticMesh());
+	for (int i = 0; i < ProjectileMesh->GetNumMaterials(); ++i)
+	{
+		Instances->SetMaterial(i, ProjectileMesh->GetMaterial(i));
+	}
+	Instances->SetupAttachment(TracerActor->GetRootComponent());
+	Instances->RegisterComponent();
+
+	FTracerBatch& Batch = Batches.Add(ProjectileClass);
+	Batch.Instances = Instances;
+	Batch.Scale = ProjectileMesh->GetRelativeScale3D();
+	Batch.GravityZ = GetWorld()->GetGravityZ() * ProjectileDefaultObject->Movement->ProjectileGravityScale;
+	return &Batch;
+}
+
+void USubmarineTracerSubsystem::AddTracer(
+	TSubclassOf<ASubmarineProjectile> ProjectileClass,
+	const FVector& Position,
+	const FQuat& Rotation,
+	const FVector& Velocity,
+	const float LifeSpan,
+	const AActor* IgnoredActor)
+{
+	LLM_SCOPE_BYTAG(Submarine_Projectile);
+	if (ProjectileClass == nullptr || LifeSpan <= 0.f)
+	{
+		return;
+	}
+	FTracerBatch* Batch = FindOrCreateBatch(ProjectileClass);
+	if (Batch == nullptr || !Batch->Instances.IsValid())
+	{
+		return;
+	}
+
+	// One trace per round up front, instead of per frame, so tracers don't fly through walls
+	float RemainingLife = LifeSpan;
+	FHitResult Hit;
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(SubmarineTracer), false, IgnoredActor);
+	if (GetWorld()->LineTraceSingleByChannel(
+		Hit, Position, Position + Velocity * LifeSpan, ECC_Visibility, QueryParams))
+	{
+		RemainingLife = LifeSpan * Hit.Time;
+	}
+
+	Batch->Positions.Add(Position);
+	Batch->Velocities.Add(Velocity);
+	Batch->RemainingLife.Add(RemainingLife);
+	Batch->Transforms.Add(FTransform(Rotation, Position, Batch->Scale));
+	Batch->Instances->AddInstance(Batch->Transforms.Last(), true);
+}
+
+void USubmarineTracerSubsystem::Tick(float DeltaTime)
+{
+	for (auto& Pair: Batches)
+	{
+		if (Pair.Value.Positions.Num() > 0)
+		{
+			TickBatch(Pair.Value, DeltaTime);
+		}
+	}
+}
+
+void USubmarineTracerSubsystem::TickBatch(FTracerBatch& Batch, const float DeltaTime)
+{
+	UInstancedStaticMeshComponent* Instances = Batch.Instances.Get();
+	if (Instances == nullptr)
+	{
+		return;
+	}
+
+	for (int i = Batch.Positions.Num() - 1; i >= 0; --i)
+	{
+		Batch.RemainingLife[i] -= DeltaTime;
+		if (Batch.RemainingLife[i] <= 0.f)
+		{
+			Batch.Positions.RemoveAtSwap(i, 1, false);
+			Batch.Velocities.RemoveAtSwap(i, 1, false);
+			Batch.RemainingLife.RemoveAtSwap(i, 1, false);
+			Batch.Transforms.RemoveAtSwap(i, 1, false);
+			continue;
+		}
+		Batch.Velocities[i].Z += Batch.GravityZ * DeltaTime;
+		Batch.Positions[i] += Batch.Velocities[i] * DeltaTime;
+		Batch.Transforms[i].SetLocation(Batch.Positions[i]);
+		Batch.Transforms[i].SetRotation(Batch.Velocities[i].ToOrientationQuat());
+	}
+
+	// Instances are interchangeable, so only ever add or remove them at the end and rewrite them all in one go
+	const int32 NumTracers = Batch.Transforms.Num();
+	while (Instances->GetInstanceCount() > NumTracers)
+	{
+		Instances->RemoveInstance(Instances->GetInstanceCount() - 1);
+	}
+	if (NumTracers > 0)
+	{
+		Instances->BatchUpdateInstancesTransforms(0, Batch.Transforms, true, true, true);
+	}
+}
@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SubmarineTracerSubsystem.generated.h"
+
+class ASubmarineProjectile;
+class UInstancedStaticMeshComponent;
+
+/**
+ * Client-only cosmetic rounds. Every visual-only shot (our own and other players') is drawn as one instance of an
+ * instanced mesh per projectile class - no actor spawn, component registration or physics body per round.
+ * Real projectiles only exist on the Server.
+ */
+UCLASS()
+class ANTIQUATEDFUTURE_API USubmarineTracerSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+	struct FTracerBatch
+	{
+		TWeakObjectPtr<UInstancedStaticMeshComponent> Instances;
+		FVector Scale = FVector::OneVector;
+		float GravityZ = 0.f;
+		TArray<FVector> Positions;
+		TArray<FVector> Velocities;
+		TArray<float> RemainingLife;
+		TArray<FTransform> Transforms;
+	};
+
+	TMap<TSubclassOf<ASubmarineProjectile>, FTracerBatch> Batches;
+
+	// Owns all the instanced mesh components
+	UPROPERTY()
+	TObjectPtr<AActor> TracerActor;
+
+	FTracerBatch* FindOrCreateBatch(TSubclassOf<ASubmarineProjectile> ProjectileClass);
+	void TickBatch(FTracerBatch& Batch, const float DeltaTime);
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	void AddTracer(
+		TSubclassOf<ASubmarineProjectile> ProjectileClass,
+		const FVector& Position,
+		const FQuat& Rotation,
+		const FVector& Velocity,
+		const float LifeSpan,
+		const AActor* IgnoredActor);
+};
@@ -2,17 +2,22 @@
 
 
 #include "SubmarineWeapons.h"
+#include "AntiquatedFuture.h"
+#include "SubmarineArchetypeSubsystem.h"
+#include "SubmarineNetQuality.h"
+#include "SubmarinePawn.h"
 #include "SubmarineProjectile.h"
+#include "SubmarineTracerSubsystem.h"
 #include "GameFramework/ProjectileMovementComponent.h"
 #include "EnhancedInputComponent.h"
 #include "GameFramework/GameState.h"
 #include "GameFramework/GameStateBase.h"
-#include "Net/UnrealNetwork.h"
 
 
 // Sets default values for this component's properties
 USubmarineWeapon::USubmarineWeapon()
 {
+	LLM_SCOPE_BYTAG(Submarine_Weapon);
 	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
 	// off to improve performance if you don't need them.
 	PrimaryComponentTick.bCanEverTick = true;
@@ -20,38 +25,37 @@ USubmarineWeapon::USubmarineWeapon()
 
 	BaseFireRate = 10.f;
 	DummyProjectileLifeSpan = 0.2f;
+	ProxyProjectileLifeSpan = 1.f;
 }
 
-void USubmarineWeapon::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+void USubmarineWeapon::StartShootingRemote(const float PhaseTimestamp)
 {
-	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
-	DOREPLIFETIME_CONDITION(USubmarineWeapon, bIsShooting, COND_SkipOwner);
+	bIsShooting = true;
+	StartedShooting.Broadcast();
+	// Line up with the shots the Server is actually firing, rather than starting over from whenever this arrived
+	const float ShotsSinceStart = FMath::Max(FMath::FloorToFloat((Now() - PhaseTimestamp) / PeriodBetweenShots), 0.f);
+	TimeLastFired = PhaseTimestamp + ShotsSinceStart * PeriodBetweenShots;
+	// Tick only draws the shots after this one, so the shot that started the burst needs its own tracer
+	if (!bIsDisabledBecauseJuggernaut)
+	{
+		ShootProxyTracer();
+	}
 }
 
-void USubmarineWeapon::OnRep_IsShooting()
+void USubmarineWeapon::StopShootingRemote()
 {
-	if (Instigator->IsLocallyControlled() || GetOwnerRole() != ROLE_SimulatedProxy)
-	{
-		UE_LOG(LogTemp, Error, TEXT("OnRep notify called somewhere besides Simulated Proxy! This shouldn't happen!"))
-	}
-	
-	if (bIsShooting)
-	{
-		StartedShooting.Broadcast();
-		TimeLastFired = Now();
-		ShotFired.Broadcast();
-	}
-	else
-	{
-		StoppedShooting.Broadcast();
-	}
+	bIsShooting = false;
+	StoppedShooting.Broadcast();
 }
 
 
 // Called when the game starts
 void USubmarineWeapon::BeginPlay()
 {
+	LLM_SCOPE_BYTAG(Submarine_Weapon);
 	Super::BeginPlay();
+	// Older Blueprints still have Component Replicates ticked, but everything we need goes through the Pawn now
+	SetIsReplicated(false);
 	// IMPORTANT: We don't support modifying BaseFireRate during play
 	PeriodBetweenShots = 1.f / BaseFireRate;
 	bWasShootingLastTick = false;
@@ -59,24 +63,16 @@ void USubmarineWeapon::BeginPlay()
 	// Initialize events to an arbitrary point in the past
 	TimeLastStoppedShooting = Now() - PeriodBetweenShots;
 	TimeLastFired = TimeLastStoppedShooting - PeriodBetweenShots;
-	NewProjectiles = TArray<TObjectPtr<ASubmarineProjectile>>();
-	const auto ProjectileDefaultObject = Projectile->GetDefaultObject();
-	TArray<UObject*> ProjectileComponents;
-	ProjectileDefaultObject->GetDefaultSubobjects(ProjectileComponents);
+	// Ballistic constants are cached once per projectile class, not once per weapon
 	InitialProjectileSpeed = -1.f;
-	for (int i = 0; i < ProjectileComponents.Num(); i++)
+	const auto GameInstance = GetWorld()->GetGameInstance();
+	if (const auto Archetypes = GameInstance ? GameInstance->GetSubsystem<USubmarineArchetypeSubsystem>() : nullptr)
 	{
-		const auto MovementComponent = Cast<UProjectileMovementComponent>(ProjectileComponents[i]);
-		if (MovementComponent)
-		{
-			UE_LOG(LogTemp, Log, TEXT("Caching initial projectile speed: %f"), MovementComponent->InitialSpeed);
-			InitialProjectileSpeed = MovementComponent->InitialSpeed;
-			break;
-		}
+		InitialProjectileSpeed = Archetypes->GetProjectileArchetype(Projectile).InitialSpeed;
 	}
 	if (InitialProjectileSpeed < 0.f)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Unable to cache projectile speed. This could cause problems!"));
+		UE_LOG(LogSubmarine, Warning, TEXT("Unable to cache projectile speed. This could cause problems!"));
 	}
 
 	// const auto RoleName = UEnum::GetValueAsString(GetOwnerRole());
@@ -111,30 +107,32 @@ void USubmarineWeapon::TickComponent(float DeltaTime, ELevelTick TickType,
 		// Otherwise we're just continuing to shoot
 		else if (GetOwnerRole() == ROLE_Authority)
 		{
-			for (int i = 0; i < NewProjectiles.Num(); i++)
-			{
-				if (NewProjectiles[i])
-				{
-					NewProjectiles[i]->TearOff();
-				}
-			}
-			NewProjectiles.Empty();
 			InterpolateAndShoot(CurrentTime);
 		}
 		else if (GetOwnerRole() == ROLE_SimulatedProxy)
 		{
 			TimeLastFired = TimeLastFired + PeriodBetweenShots;
-			ShotFired.Broadcast();
+			ShootProxyTracer();
 		}
 	}
 }
 
+void USubmarineWeapon::ShootProxyTracer()
+{
+	// Projectiles only exist on the Server, so draw our own approximation of what they're shooting
+	const FQuat ShotRotation = PlayerLookComponent.IsValid()
+		? PlayerLookComponent->GetComponentQuat() : GetComponentQuat();
+	SpawnCosmeticTracer(0.f, GetOwner()->GetVelocity(), GetComponentLocation(), ShotRotation,
+		ProxyProjectileLifeSpan);
+	ShotFired.Broadcast();
+}
+
 
 void USubmarineWeapon::BindToPlayer(
 	USceneComponent* PlayerLook)
 {
 	const auto ActionName = ShootAction->StaticClass()->GetName();
-	UE_LOG(LogTemp, Log, TEXT("Binding %s..."), *ActionName);
+	UE_LOG(LogSubmarine, Verbose, TEXT("Binding %s..."), *ActionName);
 	PlayerLookComponent = PlayerLook;
 }
 
@@ -207,9 +205,13 @@ void USubmarineWeapon::StopShootingLocalOnly(const float TimeStamp)
 {
 	bIsShooting = false;
 	TimeLastStoppedShooting = TimeStamp;
+	UpdateOwnerFiringState(TimeStamp);
 	if (GetOwnerRole() != ROLE_Authority)
 	{
-		ServerStopShooting(TimeStamp);
+		if (const auto SubmarinePawn = Cast<ASubmarinePawn>(GetOwner()))
+		{
+			SubmarinePawn->SendStopShooting(this, TimeStamp);
+		}
 	}
 }
 
@@ -221,7 +223,7 @@ void USubmarineWeapon::SetInstigator(APawn* OwningPawn)
 	}
 	else
 	{
-		UE_LOG(LogTemp, Error, TEXT("No Instigator to assign!"))
+		UE_LOG(LogSubmarine, Error, TEXT("No Instigator to assign!"))
 	}
 }
 
@@ -229,40 +231,48 @@ void USubmarineWeapon::SetInstigator(APawn* OwningPawn)
 void USubmarineWeapon::StartShootingLocalOnly(const float TimeStamp)
 {
 	bIsShooting = true;
+	UpdateOwnerFiringState(TimeStamp);
 	// This shouldn't happen...
 	if (!Instigator->IsLocallyControlled())
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Invoked StartShooting from somewhere other than Owner or Server"))
+		UE_LOG(LogSubmarine, Warning, TEXT("Invoked StartShooting from somewhere other than Owner or Server"))
 		return;
 	}
-	// True bullets will be spawned by the Server and replicated
-	// This just initializes our tracking of the simulated bullets without actually spawning anything
+	// True bullets will only ever be spawned by the Server
+	// This just initializes our tracking of the simulated bullets and draws a cosmetic tracer for the first shot
 	ShootFromCurrentTransform(TimeStamp);
 
 	if (GetOwnerRole() != ROLE_Authority)
 	{
-		ServerStartShooting(TimeStamp, LastFiredPosition, LastFiredOrientation, LastFiredVelocity);
+		if (const auto SubmarinePawn = Cast<ASubmarinePawn>(GetOwner()))
+		{
+			SubmarinePawn->SendStartShooting(this, TimeStamp, LastFiredPosition, LastFiredOrientation,
+				LastFiredVelocity);
+		}
 	}
 }
 
-void USubmarineWeapon::ServerStartShooting_Implementation(const float TimeStamp,
-	const FVector_NetQuantize CurrentPosition, const FQuat CurrentRotation, const FVector_NetQuantize10 CurrentVelocity)
+void USubmarineWeapon::StartShootingOnServer(const float TimeStamp,
+	const FVector_NetQuantize& CurrentPosition, const FQuat& CurrentRotation,
+	const FVector_NetQuantize10& CurrentVelocity)
 {
 	if (bIsShooting)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Server told to Start shooting multiple times in a row. How?!"))
+		SUBMARINE_LOG_RATE_LIMITED(1.0, LogSubmarineNet, Warning,
+			TEXT("Server told to Start shooting multiple times in a row. How?!"));
 	}
 	else
 	{
 		//UE_LOG(LogTemp, Log, TEXT("Server starting to shoot."))
 	}
 	bIsShooting = true;
+	UpdateOwnerFiringState(TimeStamp);
 
 	ShootProjectile(TimeStamp, CurrentVelocity, CurrentPosition, CurrentRotation);
 	//MulticastStartShooting(TimeStamp, CurrentPosition, CurrentRotation, CurrentVelocity);
 }
 
-void USubmarineWeapon::ServerStopShooting_Implementation(const float TimeStamp)
+void USubmarineWeapon::StopShootingOnServer(const float TimeStamp)
 {
 	if (bIsShooting)
 	{
@@ -270,13 +280,27 @@ void USubmarineWeapon::ServerStopShooting_Implementation(const float TimeStamp)
 	}
 	else
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Server told to Stop shooting multiple times in a row?!"));
+		SUBMARINE_LOG_RATE_LIMITED(1.0, LogSubmarineNet, Warning,
+			TEXT("Server told to Stop shooting multiple times in a row?!"));
 	}
 	bIsShooting = false;
 	TimeLastStoppedShooting = TimeStamp;
+	UpdateOwnerFiringState(TimeStamp);
 	//MulticastStopShooting(TimeStamp);
 }
 
+void USubmarineWeapon::UpdateOwnerFiringState(const float TimeStamp) const
+{
+	if (GetOwnerRole() != ROLE_Authority)
+	{
+		return;
+	}
+	if (const auto SubmarinePawn = Cast<ASubmarinePawn>(GetOwner()))
+	{
+		SubmarinePawn->SetWeaponFiring(this, bIsShooting, TimeStamp);
+	}
+}
+
 // void USubmarineWeapon::ServerShoot_Implementation(const float TimeStamp, const FVector_NetQuantize10 Position,
 // 	const FQuat Rotation)
 // {
@@ -287,25 +311,28 @@ void USubmarineWeapon::InterpolateAndShoot(const float CurrentTime)
 	float TimeOvershoot = CurrentTime - TimeLastFired;
 	if (TimeOvershoot < PeriodBetweenShots - FLT_EPSILON)
 	{
-		UE_LOG(LogTemp, Error, TEXT("Attempting to shoot before cooldown elapsed..."))
+		SUBMARINE_LOG_RATE_LIMITED(1.0, LogSubmarine, Error, TEXT("Attempting to shoot before cooldown elapsed..."));
 		return;
 	}
 	if (TimeOvershoot > 2 * PeriodBetweenShots && TimeLastStoppedShooting < TimeLastFired)
 	{
 		if (TimeLastStoppedShooting < TimeLastFired)
 		{
-			UE_LOG(LogTemp, Log, TEXT("Too much Tick time is elapsing between shots. Making up the difference"))
+			SUBMARINE_LOG_RATE_LIMITED(1.0, LogSubmarine, Verbose,
+				TEXT("Too much Tick time is elapsing between shots. Making up the difference"));
 			InterpolateAndShoot(CurrentTime - PeriodBetweenShots);
 			// The recursive call will have updated TimeLastFired, meaning we should calculate the new overshoot
 			TimeOvershoot = CurrentTime - TimeLastFired;
 			if (TimeOvershoot > 2 * PeriodBetweenShots)
 			{
-				UE_LOG(LogTemp, Error, TEXT("Recursive call should have taken care of that..."))
+				SUBMARINE_LOG_RATE_LIMITED(1.0, LogSubmarine, Error,
+					TEXT("Recursive call should have taken care of that..."));
 			}
 		}
 		else
 		{
-			UE_LOG(LogTemp, Warning, TEXT("I'm pretty sure this can't happen. Resetting shot history."))
+			SUBMARINE_LOG_RATE_LIMITED(1.0, LogSubmarine, Warning,
+				TEXT("I'm pretty sure this can't happen. Resetting shot history."));
 			ShootFromCurrentTransform(CurrentTime);
 		}
 	}
@@ -335,8 +362,16 @@ ASubmarineProjectile* USubmarineWeapon::ShootProjectile(
 	float DeltaTime = CurrentTime - TimeStamp;
 	if (DeltaTime < -FLT_EPSILON)
 	{
-		UE_LOG(LogTemp, Warning, TEXT(
-			"Attempting to spawn projectile %f seconds before it was fired. Setting to 0."), DeltaTime);
+		SUBMARINE_LOG_RATE_LIMITED(1.0, LogSubmarineNet, Warning,
+			TEXT("Attempting to spawn projectile %f seconds before it was fired. Setting to 0."), DeltaTime);
+		const auto NetQuality = USubmarineNetQualitySubsystem::IsEnabled()
+			? GetWorld()->GetSubsystem<USubmarineNetQualitySubsystem>()
+			: nullptr;
+		if (NetQuality)
+		{
+			NetQuality->Record(Cast<ASubmarinePawn>(Instigator), ESubmarineNetQualityMetric::FutureTimestamp,
+				-DeltaTime * 1000.f);
+		}
 		DeltaTime = 0;
 	}
 
@@ -344,20 +379,11 @@ ASubmarineProjectile* USubmarineWeapon::ShootProjectile(
 	if (GetOwnerRole() == ROLE_Authority)
 	{
 		SubmarineProjectile = SpawnProjectile(DeltaTime, InheritedVelocity, Position, Rotation);
-		if (SubmarineProjectile)
-		{
-			// TearOff these projectiles after they've had a chance to Tick since the client-side sim is visual only
-			// Add them to this list to be torn off next frame
-			NewProjectiles.Add(SubmarineProjectile);
-		}
 	}
 	else if (Instigator->IsLocallyControlled())
 	{
-		SubmarineProjectile = SpawnProjectile(DeltaTime, InheritedVelocity, Position, Rotation);
-		if (SubmarineProjectile)
-		{
-			SubmarineProjectile->SetLifeSpan(DummyProjectileLifeSpan);
-		}
+		// True bullets only exist on the Server - this one is visual only
+		SpawnCosmeticTracer(DeltaTime, InheritedVelocity, Position, Rotation, DummyProjectileLifeSpan);
 	}
 	
 	TimeLastFired = TimeStamp;
@@ -374,7 +400,7 @@ ASubmarineProjectile* USubmarineWeapon::SpawnProjectile(
 {
 	if (Instigator == nullptr)
 	{
-		UE_LOG(LogTemp, Error, TEXT("No Instigator set in SubmarineWeapons - did it fail to Replicate?"))
+		UE_LOG(LogSubmarine, Error, TEXT("No Instigator set in SubmarineWeapons - did it fail to Replicate?"))
 	}
 	const auto ProjectileForwardVelocity = Rotation.GetForwardVector() * InitialProjectileSpeed;
 	const auto Displacement = DeltaTime * ProjectileForwardVelocity;
@@ -383,11 +409,11 @@ ASubmarineProjectile* USubmarineWeapon::SpawnProjectile(
 	FActorSpawnParameters ActorSpawnParameters = FActorSpawnParameters();
 	//ActorSpawnParameters.Owner = GetOwner();
 	ActorSpawnParameters.Instigator = Instigator;
-	const auto ProjectileDefaultObject = Projectile->GetDefaultObject();
-	const auto ProjectileClass = ProjectileDefaultObject->GetClass();
+	// The weapon asks, but the projectile owns whatever gets allocated
+	LLM_SCOPE_BYTAG(Submarine_Projectile);
 	ASubmarineProjectile* SubmarineProjectile = nullptr;
 	if (const auto ProjectileActor = GetWorld()->SpawnActor(
-		ProjectileClass, &CurrentLocation, &Rotator, ActorSpawnParameters))
+		Projectile, &CurrentLocation, &Rotator, ActorSpawnParameters))
 	{
 		SubmarineProjectile = Cast<ASubmarineProjectile>(ProjectileActor);
 		if (SubmarineProjectile)
@@ -398,23 +424,40 @@ ASubmarineProjectile* USubmarineWeapon::SpawnProjectile(
 			}
 			else
 			{
-				UE_LOG(LogTemp, Error, TEXT("Failed to get ProjectileMovementComponent!"))
+				UE_LOG(LogSubmarine, Error, TEXT("Failed to get ProjectileMovementComponent!"))
 			}
 		}
 		else
 		{
-			UE_LOG(LogTemp, Error, TEXT("Failed to cast to SubmarineProjectile!"))
+			UE_LOG(LogSubmarine, Error, TEXT("Failed to cast to SubmarineProjectile!"))
 		}
 	}
 	else
 	{
-		UE_LOG(LogTemp, Error, TEXT("Failed to spawn projectile!"))
+		UE_LOG(LogSubmarine, Error, TEXT("Failed to spawn projectile!"))
 	}
 
 	return SubmarineProjectile;
 }
 
 
+void USubmarineWeapon::SpawnCosmeticTracer(
+	const float DeltaTime,
+	const FVector_NetQuantize10& InheritedVelocity,
+	const FVector_NetQuantize& Position,
+	const FQuat& Rotation,
+	const float LifeSpan) const
+{
+	const auto Tracers = GetWorld()->GetSubsystem<USubmarineTracerSubsystem>();
+	if (Tracers == nullptr)
+	{
+		return;
+	}
+	const FVector Velocity = Rotation.GetForwardVector() * InitialProjectileSpeed + InheritedVelocity;
+	Tracers->AddTracer(Projectile, Position + Velocity * DeltaTime, Rotation, Velocity, LifeSpan - DeltaTime,
+		GetOwner());
+}
+
 // void USubmarineWeapon::MulticastStopShooting_Implementation(const float TimeStamp)
 // {
 // 	if (GetOwnerRole() == ROLE_AutonomousProxy)
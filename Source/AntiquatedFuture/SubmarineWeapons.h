@@ -59,8 +59,15 @@ protected:
 		const FVector_NetQuantize& Position,
 		const FQuat& Rotation);
 
-	UPROPERTY()
-	TArray<TObjectPtr<ASubmarineProjectile>> NewProjectiles; 
+	void SpawnCosmeticTracer(
+		const float DeltaTime,
+		const FVector_NetQuantize10& InheritedVelocity,
+		const FVector_NetQuantize& Position,
+		const FQuat& Rotation,
+		const float LifeSpan) const;
+	// Simulated Proxies: a tracer and ShotFired for one of the Server's shots
+	void ShootProxyTracer();
+
 	UPROPERTY()
 	TObjectPtr<APawn> Instigator;
 
@@ -68,14 +75,13 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly)
 	float DummyProjectileLifeSpan;
 
-	UFUNCTION(Server, Reliable)
-	void ServerStartShooting(
-		const float TimeStamp,
-		const FVector_NetQuantize CurrentPosition,
-		const FQuat CurrentRotation,
-		const FVector_NetQuantize10 CurrentVelocity);
-	UFUNCTION(Server, Reliable)
-	void ServerStopShooting(const float TimeStamp);
+	// How long Simulated Proxies' (visual only) projectiles live for, unless they hit something first
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	float ProxyProjectileLifeSpan;
+
+	// Weapons don't replicate themselves. The Server tells the owning Pawn, which replicates every weapon's firing state
+	// in one go (see ASubmarinePawn::FiringState).
+	void UpdateOwnerFiringState(const float TimeStamp) const;
 	// UFUNCTION(NetMulticast, Reliable)
 	// void MulticastStartShooting(
 	// 	const float TimeStamp,
@@ -91,12 +97,17 @@ public:
 	// 	FActorComponentTickFunction* ThisTickFunction) override;
 	float Now() const;
 
-	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
-
-	UPROPERTY(ReplicatedUsing=OnRep_IsShooting)
 	bool bIsShooting;
-	UFUNCTION()
-	void OnRep_IsShooting();
+	// Server: relayed by the owning Pawn's RPCs
+	void StartShootingOnServer(
+		const float TimeStamp,
+		const FVector_NetQuantize& CurrentPosition,
+		const FQuat& CurrentRotation,
+		const FVector_NetQuantize10& CurrentVelocity);
+	void StopShootingOnServer(const float TimeStamp);
+	// Simulated Proxies: driven by the owning Pawn's replicated firing state
+	void StartShootingRemote(const float PhaseTimestamp);
+	void StopShootingRemote();
 
 	void HandleShootAction(const FInputActionValue& ActionValue);
 	virtual bool CanShoot(const float TimeStamp);
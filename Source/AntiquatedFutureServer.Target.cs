@@ -0,0 +1,20 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+using System.Collections.Generic;
+
+public class AntiquatedFutureServerTarget : TargetRules
+{
+	public AntiquatedFutureServerTarget(TargetInfo Target) : base(Target)
+	{
+		Type = TargetType.Server;
+		bUsesSteam = true;
+		DefaultBuildSettings = BuildSettingsVersion.V4;
+		IncludeOrderVersion = EngineIncludeOrderVersion.Unreal5_3;
+		ExtraModuleNames.Add("AntiquatedFuture");
+
+		// Picks up the server tuning in Config/Custom/Server
+		CustomConfig = "Server";
+		BuildEnvironment = TargetBuildEnvironment.Unique;
+	}
+}